@@ -0,0 +1,292 @@
+#include "graph_utils.hh"
+#include "graph_utils_algorithms.hh"
+#include "graph_utils_ch.hh"
+#include "graph_struct.hh"
+#include "graph_utils_builder.hh"
+#include "graph_utils_stats.hh"
+#include "graph_utils_memory.hh"
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+
+//Allocation counters, fed by the global operator new replaced in bench_alloc.cpp
+extern std::atomic<size_t> numAllocations, allocatedBytes;
+
+struct Settings {
+    unsigned int nodes = 100000, edges = 500000;
+    GraphModel model = ERDOS_RENYI;
+    uint64_t seed = 1;
+    int warmup = 1, reps = 5, queries = 100;
+    unsigned int threads = 0;
+    unsigned int floydMaxNodes = 2000, chMaxNodes = 50000;
+    bool json = false, trace = false, arena = false, unweighted = false;
+    std::string filter, file = "bench.graph";
+};
+
+struct Result {
+    std::string name;
+    std::vector<long long> times;   //ns, one per repetition
+    size_t items;                   //work done by one repetition, in units
+    std::string unit;
+    long peakRssKb;
+    size_t allocations, bytes;      //per repetition
+};
+
+//Forgets the peak resident set size so far (Linux only), so that each benchmark gets its own
+static void resetPeakRss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+//Peak resident set size in KiB since the last reset, or since the start of the process if resetting is not supported
+static long peakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line)) {
+        if(line.rfind("VmHWM:", 0) == 0) {
+            return std::atol(line.c_str() + 6);
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/* Runs body warmup times, then reps timed times, keeping the allocations and the peak memory of the timed runs */
+static Result measure(Settings const& settings, std::string const& name, size_t const items, std::string const& unit, std::function<void()> const& body) {
+    Result result{name, {}, items, unit, 0, 0, 0};
+    for (int i = 0; i < settings.warmup; i++) {
+        body();
+    }
+    resetPeakRss();
+    //Only the body may allocate between the two readings of the counters: the times are reserved before,
+    //and the peak memory (whose stream allocates) is read after
+    result.times.reserve(settings.reps);
+    size_t const allocations = numAllocations, bytes = allocatedBytes;
+    for (int i = 0; i < settings.reps; i++) {
+        auto const start = std::chrono::steady_clock::now();
+        body();
+        auto const stop = std::chrono::steady_clock::now();
+        result.times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+    }
+    result.allocations = (numAllocations - allocations) / std::max(1, settings.reps);
+    result.bytes = (allocatedBytes - bytes) / std::max(1, settings.reps);
+    result.peakRssKb = peakRssKb();
+    return result;
+}
+
+static void print(Settings const& settings, Result const& result) {
+    static char const* const models[] = {"erdos_renyi", "rmat", "grid", "geometric"};
+    std::vector<long long> times = result.times;
+    std::sort(times.begin(), times.end());
+    long long const median = times[times.size() / 2];
+    long long sum = 0;
+    for (long long const t : times) {
+        sum += t;
+    }
+    double const perSecond = median > 0 ? result.items * 1e9 / median : 0;
+    if(settings.json) {
+        std::printf("{\"benchmark\":\"%s\",\"model\":\"%s\",\"nodes\":%u,\"edges\":%u,\"threads\":%u,\"warmup\":%d,\"reps\":%d,"
+                    "\"min_ns\":%lld,\"median_ns\":%lld,\"mean_ns\":%lld,\"items\":%zu,\"unit\":\"%s\",\"items_per_s\":%.1f,"
+                    "\"peak_rss_kb\":%ld,\"allocs_per_rep\":%zu,\"bytes_per_rep\":%zu}\n",
+                    result.name.c_str(), models[settings.model], settings.nodes, settings.edges, settings.threads, settings.warmup,
+                    settings.reps, times.front(), median, sum / (long long)times.size(), result.items, result.unit.c_str(), perSecond,
+                    result.peakRssKb, result.allocations, result.bytes);
+    } else {
+        std::printf("%s,%s,%u,%u,%u,%d,%d,%lld,%lld,%lld,%zu,%s,%.1f,%ld,%zu,%zu\n",
+                    result.name.c_str(), models[settings.model], settings.nodes, settings.edges, settings.threads, settings.warmup,
+                    settings.reps, times.front(), median, sum / (long long)times.size(), result.items, result.unit.c_str(), perSecond,
+                    result.peakRssKb, result.allocations, result.bytes);
+    }
+    std::fflush(stdout);
+}
+
+static bool parseArguments(int argc, char** argv, Settings& settings) {
+    for (int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "--json") {
+            settings.json = true;
+            continue;
+        }
+        if(arg == "--trace") {
+            settings.trace = true;
+            continue;
+        }
+        if(arg == "--arena") {
+            settings.arena = true;
+            continue;
+        }
+        if(arg == "--unweighted") {
+            settings.unweighted = true;
+            continue;
+        }
+        if(i + 1 >= argc) {
+            return false;
+        }
+        std::string const value = argv[++i];
+        if(arg == "--nodes") settings.nodes = std::stoul(value);
+        else if(arg == "--edges") settings.edges = std::stoul(value);
+        else if(arg == "--seed") settings.seed = std::stoull(value);
+        else if(arg == "--warmup") settings.warmup = std::stoi(value);
+        else if(arg == "--reps") settings.reps = std::stoi(value);
+        else if(arg == "--queries") settings.queries = std::stoi(value);
+        else if(arg == "--threads") settings.threads = std::stoul(value);
+        else if(arg == "--floyd-max-nodes") settings.floydMaxNodes = std::stoul(value);
+        else if(arg == "--ch-max-nodes") settings.chMaxNodes = std::stoul(value);
+        else if(arg == "--filter") settings.filter = value;
+        else if(arg == "--file") settings.file = value;
+        else if(arg == "--model") {
+            if(value == "erdos_renyi") settings.model = ERDOS_RENYI;
+            else if(value == "rmat") settings.model = RMAT;
+            else if(value == "grid") settings.model = GRID;
+            else if(value == "geometric") settings.model = GEOMETRIC;
+            else return false;
+        }
+        else return false;
+    }
+    return settings.reps > 0 && settings.warmup >= 0 && settings.queries > 0;
+}
+
+int main(int argc, char** argv)
+{
+    Settings settings;
+    if(!parseArguments(argc, argv, settings)) {
+        std::cerr << argv[0] << " usage [--nodes n] [--edges m] [--model erdos_renyi|rmat|grid|geometric] [--seed s]"
+                  << " [--warmup w] [--reps r] [--queries q] [--threads t] [--floyd-max-nodes n] [--ch-max-nodes n]"
+                  << " [--filter substring] [--file scratch_file] [--json] [--trace] [--arena] [--unweighted]" << std::endl;
+        return 1;
+    }
+    //The records of the instrumented algorithms go to stderr; they only exist in builds with GRAPH_STATS_ENABLED
+    StatsTracer tracer(std::cerr);
+    if(settings.trace) {
+        myGraphUtils::setStatsObserver(&tracer);
+    }
+    GraphBuilder<int,int> builder;
+    builder.setNumNodes(settings.nodes).setNumEdges(settings.edges).setModel(settings.model).setSeed(settings.seed)
+           .setNumThreads(settings.threads).setEdgeWeightLimits(1, 100).setWeightedEdges(!settings.unweighted);
+    std::optional<Graph<int,int>> generated = builder.build();
+    if(!generated || generated->getNumNodes() == 0) {
+        std::cerr << "Can not generate a graph with these settings" << std::endl;
+        return 1;
+    }
+    Graph<int,int> const& graph = generated.value();
+    CsrGraph<int,int> const csr = graph.freeze();
+    size_t const m = graph.getNumEdges();
+    //The same random queries for every point to point engine
+    std::mt19937_64 gen(settings.seed);
+    std::uniform_int_distribution<int> node(0, graph.getNumNodes() - 1);
+    std::vector<std::pair<int,int>> queries(settings.queries);
+    for (std::pair<int,int>& query : queries) {
+        query = {csr.getId(node(gen)), csr.getId(node(gen))};
+    }
+    if(!settings.json) {
+        std::printf("benchmark,model,nodes,edges,threads,warmup,reps,min_ns,median_ns,mean_ns,items,unit,items_per_s,peak_rss_kb,allocs_per_rep,bytes_per_rep\n");
+    }
+    auto run = [&](std::string const& name, size_t const items, std::string const& unit, std::function<void()> const& body) {
+        if(name.find(settings.filter) == std::string::npos) {
+            return;
+        }
+        //With --arena every repetition takes its temporaries from a fresh scratch arena
+        if(settings.arena) {
+            print(settings, measure(settings, name, items, unit, [&]() { ScratchArena arena; body(); }));
+        } else {
+            print(settings, measure(settings, name, items, unit, body));
+        }
+    };
+    //Loaders
+    std::string const binaryFile = settings.file + ".bin";
+    GraphBuilder<int,int>(builder).setOutputFile(settings.file).build();
+    csr.save(binaryFile);
+    run("GraphBuilder::build", m, "edges", [&]() { builder.build(); });
+    run("initGraph", m, "edges", [&]() { Graph<int,int> g; myGraphUtils::initGraph(settings.file, g); });
+    run("parseGraph", m, "edges", [&]() { Graph<int,int> g; myGraphUtils::parseGraph(settings.file, g, settings.threads); });
+    run("CsrGraph::map", m, "edges", [&]() { CsrGraph<int,int>::map(binaryFile); });
+    run("Graph::freeze", m, "edges", [&]() { graph.freeze(); });
+    //Spanning trees
+    run("compute_SST_Kruskal", m, "edges", [&]() { compute_SST_Kruskal(csr, KRUSKAL_AUTO, settings.threads); });
+    run("compute_SST_Boruvka", m, "edges", [&]() { compute_SST_Boruvka(csr, settings.threads); });
+    run("compute_SST_Prim", m, "edges", [&]() { compute_SST_Prim(csr); });
+    //Traversals
+    CsrGraph<int,int> const reverse = csr.reversed();
+    run("isConnected", m, "edges", [&]() { myGraphUtils::isConnected(csr); });
+    run("compute_BFS", m, "edges", [&]() { compute_BFS(csr, reverse, queries[0].first, settings.threads); });
+    run("compute_Components", m, "edges", [&]() { compute_Components(csr, settings.threads); });
+    //Shortest paths
+    DijkstraWorkspace<int> workspace;
+    run("compute_SPT_Dijkstra", m, "edges", [&]() { compute_SPT_Dijkstra(csr, queries[0].first, workspace); });
+    run("compute_SPT_Delta_Stepping", m, "edges", [&]() { compute_SPT_Delta_Stepping(csr, queries[0].first, 0, settings.threads); });
+    if((long long)csr.getMaxCost() <= DIAL_MAX_COST) {
+        DialWorkspace<int> dialWorkspace;
+        run("compute_SPT_Dial", m, "edges", [&]() { compute_SPT_Dial(csr, queries[0].first, {}, dialWorkspace); });
+    }
+    if(chooseShortestPathEngine(csr) == SP_BFS) {
+        BFSWorkspace<int> bfsWorkspace;
+        run("compute_SPT_BFS", m, "edges", [&]() { compute_SPT_BFS(csr, queries[0].first, {}, bfsWorkspace); });
+    }
+    run("compute_SPT", m, "edges", [&]() { compute_SPT(csr, queries[0].first); });
+    run("compute_SP_Dijkstra", queries.size(), "queries", [&]() {
+        for (auto const& [from, to] : queries) {
+            compute_SP_Dijkstra(csr, from, to);
+        }
+    });
+    ShortestPathWorkspace<int> shortestPathWorkspace;
+    run("compute_SP", queries.size(), "queries", [&]() {
+        for (auto const& [from, to] : queries) {
+            compute_SP(csr, from, to, shortestPathWorkspace);
+        }
+    });
+    BidirectionalWorkspace<int> bidirectionalWorkspace;
+    run("compute_SP_Bidirectional_Dijkstra", queries.size(), "queries", [&]() {
+        for (auto const& [from, to] : queries) {
+            compute_SP_Bidirectional_Dijkstra(csr, reverse, from, to, bidirectionalWorkspace);
+        }
+    });
+    std::vector<DijkstraWorkspace<int>> batchWorkspaces(settings.threads > 0 ? settings.threads : myGraphUtils::defaultNumThreads());
+    run("compute_SP_Dijkstra_Batch", queries.size(), "queries", [&]() { compute_SP_Dijkstra_Batch(csr, queries, batchWorkspaces); });
+    //Only grid edges are at least as long as their cost, elsewhere A* degenerates to Dijkstra
+    float const costPerUnit = settings.model == GRID ? 1 : 0;
+    run("compute_SP_AStar", queries.size(), "queries", [&]() {
+        for (auto const& [from, to] : queries) {
+            compute_SP_AStar(csr, from, to, costPerUnit);
+        }
+    });
+    LandmarkTable<int> landmarks = compute_ALT_Landmarks(csr, 8, settings.threads);
+    run("compute_ALT_Landmarks", m, "edges", [&]() { compute_ALT_Landmarks(csr, 8, settings.threads); });
+    run("compute_SP_ALT", queries.size(), "queries", [&]() {
+        for (auto const& [from, to] : queries) {
+            compute_SP_ALT(csr, landmarks, from, to);
+        }
+    });
+    //Contraction pays off on road-like graphs; on random ones the shortcuts blow up and preprocessing takes ages
+    if(settings.nodes <= settings.chMaxNodes && (settings.model == GRID || settings.model == GEOMETRIC)) {
+        ContractionHierarchy<int> hierarchy = compute_CH(csr);
+        CHWorkspace<int> chWorkspace;
+        run("compute_CH", m, "edges", [&]() { compute_CH(csr); });
+        run("compute_SP_CH", queries.size(), "queries", [&]() {
+            for (auto const& [from, to] : queries) {
+                compute_SP_CH(csr, hierarchy, from, to, chWorkspace);
+            }
+        });
+    }
+    if(settings.nodes <= settings.floydMaxNodes) {
+        run("compute_SP_Floyd_Warshall", m, "edges", [&]() { compute_SP_Floyd_Warshall(csr); });
+        run("compute_APSP_Floyd_Warshall", m, "edges", [&]() { compute_APSP_Floyd_Warshall(csr, settings.threads); });
+        run("compute_APSP_Johnson", m, "edges", [&]() { compute_APSP_Johnson(csr, settings.threads); });
+        run("compute_APSP_Johnson_Stream", m, "edges", [&]() {
+            std::atomic<long long> reached(0);
+            compute_APSP_Johnson_Stream(csr, [&](int const, std::vector<int> const&, std::vector<int> const& predecessors) {
+                reached += std::count_if(predecessors.begin(), predecessors.end(), [](int const p) { return p != -1; });
+            }, settings.threads);
+        });
+    }
+    std::remove(settings.file.c_str());
+    std::remove(binaryFile.c_str());
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+/* Replaced global operator new and delete, counting the allocations of the bench harness. They live in their own
+   translation unit: inlined next to the standard containers, the compiler would pair their malloc and free with the
+   operator new the containers call and report a mismatch */
+
+//Allocation counters, read by bench.cpp
+std::atomic<size_t> numAllocations(0), allocatedBytes(0);
+
+static void* countedAlloc(size_t const size) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if(void* p = std::malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+//std::pmr::new_delete_resource allocates through the aligned overloads
+static void* countedAlignedAlloc(size_t const size, std::align_val_t const align) {
+    numAllocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    size_t const alignment = std::max(sizeof(void*), (size_t)align);
+    if(void* p = std::aligned_alloc(alignment, (std::max<size_t>(size, 1) + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    return countedAlignedAlloc(size, align);
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+    return countedAlignedAlloc(size, align);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
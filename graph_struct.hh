@@ -1,6 +1,7 @@
 #ifndef GRAPH_STRUCT
 #define GRAPH_STRUCT
 
+#include "graph_utils_memory.hh"
 #include <vector>
 #include <optional>
 #include <unordered_set>
@@ -8,6 +9,22 @@
 #include <functional>
 #include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <iterator>
+#include <initializer_list>
+#include <memory_resource>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 template <typename E>
 class Edge {
     private:
@@ -27,26 +44,50 @@ class Edge {
 };
 
 
+//Coordinates up to this many dimensions are stored inside the node, without a heap allocation
+constexpr unsigned int INLINE_COORDS = 3;
+
+/* The coordinates of a node: inline up to INLINE_COORDS dimensions, on the heap beyond. It takes the space of a
+   std::vector<float> and reads like one */
+class Coords {
+    private:
+        float local[INLINE_COORDS] = {};
+        unsigned int count = 0;
+        std::unique_ptr<float[]> spilled;   //only when count > INLINE_COORDS
+        void assign(float const* const values, unsigned int const size);
+    public:
+        Coords() = default;
+        Coords(float const* const values, unsigned int const size) { assign(values, size); }
+        Coords(std::initializer_list<float> const values) { assign(values.begin(), values.size()); }
+        Coords(std::vector<float> const& values) { assign(values.data(), values.size()); }
+        Coords(Coords const& other) { assign(other.data(), other.count); }
+        Coords(Coords&& other) noexcept;
+        Coords& operator=(Coords const& other);
+        Coords& operator=(Coords&& other) noexcept;
+        float const& operator[](size_t const d) const { return data()[d]; }
+        float const* data() const { return spilled ? spilled.get() : local; }
+        float const* begin() const { return data(); }
+        float const* end() const { return data() + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        bool operator==(Coords const& other) const { return count == other.count && std::equal(begin(), end(), other.begin()); }
+        bool operator!=(Coords const& other) const { return !(*this == other); }
+};
+
 template <typename N, typename E>
 class Node
 {
     private:
         N cost;
         int id;
-        std::vector<float> coords;
-        std::vector<Edge<E>> adjacentEdges;
+        Coords coords;
     public:
+        //The edges of a node are kept by its Graph, see Graph::getAdjacency
         Node() = default;
-        Node(int id, std::vector<float> const& coords, N cost = 0) : cost(cost), id(id), coords(coords) {}
-        std::vector<float> const& getCoords() const;
+        Node(int id, Coords coords, N cost = 0) : cost(cost), id(id), coords(std::move(coords)) {}
+        Coords const& getCoords() const;
         N const getCost() const;
         int const getId() const;
-        void addAdjacentEdge(Edge<E> const& edge) {
-            adjacentEdges.push_back(edge);
-        }
-        std::vector<Edge<E>> const& getAdjacentEdges() const{
-            return adjacentEdges;
-        }
         bool operator ==(Node<N,E> const& other) const {
             return (/*getCoords() == other.getCoords() || */id == other.getId());
         }
@@ -55,30 +96,564 @@ class Node
         }
 };
 
+/* The edges of a graph, each stored once as three parallel arrays: the source and target node indices, with the
+   bidirectional flag packed in the top bit of the target, and the costs on their own, so that walks following only the
+   structure never load them. I is the index type: uint32_t holds up to 2^31 nodes, uint64_t beyond */
+template <typename E, typename I = uint32_t>
+class PackedEdges {
+    static_assert(std::is_unsigned_v<I>, "PackedEdges needs an unsigned index type");
+    private:
+        std::pmr::vector<I> sources;
+        std::pmr::vector<I> targets;
+        std::pmr::vector<E> costs;
+        static constexpr I BIDIRECTIONAL = I(1) << (std::numeric_limits<I>::digits - 1);
+    public:
+        static constexpr I MAX_INDEX = BIDIRECTIONAL - 1;
+        PackedEdges() = default;
+        explicit PackedEdges(std::pmr::memory_resource* const resource) : sources(resource), targets(resource), costs(resource) {}
+        void push_back(I const source, I const target, E const cost, bool const bidirectional);
+        void reserve(size_t const count);
+        size_t size() const { return sources.size(); }
+        bool empty() const { return sources.empty(); }
+        I getSource(size_t const position) const { return sources[position]; }
+        I getTarget(size_t const position) const { return targets[position] & MAX_INDEX; }
+        bool isBidirectional(size_t const position) const { return (targets[position] & BIDIRECTIONAL) != 0; }
+        E getCost(size_t const position) const { return costs[position]; }
+        E const* getCosts() const { return costs.data(); }
+        size_t getBytes() const;
+};
+
+template <typename N, typename E>
+class Graph;
+
+/* Forward iterator over the positions of a view, yielding the element the view builds for each of them */
+template <typename V, typename T>
+class ViewIterator {
+    private:
+        V const* view;
+        size_t position;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = T;
+        ViewIterator(V const* view, size_t const position) : view(view), position(position) {}
+        T operator*() const { return (*view)[position]; }
+        ViewIterator& operator++() { position++; return *this; }
+        ViewIterator operator++(int) { ViewIterator previous = *this; position++; return previous; }
+        bool operator==(ViewIterator const& other) const { return position == other.position; }
+        bool operator!=(ViewIterator const& other) const { return position != other.position; }
+};
+
+/* All the edges of a Graph in insertion order, built on the fly from its packed storage. It stays valid until the graph changes */
+template <typename N, typename E>
+class EdgeView {
+    private:
+        Graph<N,E> const* graph = nullptr;
+    public:
+        using Iterator = ViewIterator<EdgeView<N,E>, Edge<E>>;
+        EdgeView() = default;
+        EdgeView(Graph<N,E> const& graph) : graph(&graph) {}
+        Edge<E> operator[](size_t const position) const;
+        size_t size() const;
+        bool empty() const { return size() == 0; }
+        Iterator begin() const { return Iterator(this, 0); }
+        Iterator end() const { return Iterator(this, size()); }
+};
+
+/* The edges leaving a node of a Graph, walked without copying anything: first the ones added from the node,
+   then the implied reverse of every bidirectional edge ending there, built on the fly with its ends swapped.
+   It is what the node's adjacency would be in myGraphUtils::makeDirect(graph), and stays valid until the graph changes */
+template <typename N, typename E>
+class AdjacencyView {
+    private:
+        Graph<N,E> const* graph = nullptr;
+        std::pmr::vector<unsigned int> const* stored = nullptr;    //positions in the graph edges
+        std::pmr::vector<unsigned int> const* implied = nullptr;
+    public:
+        using Iterator = ViewIterator<AdjacencyView<N,E>, Edge<E>>;
+        AdjacencyView() = default;
+        AdjacencyView(Graph<N,E> const& graph, std::pmr::vector<unsigned int> const& stored, std::pmr::vector<unsigned int> const& implied)
+            : graph(&graph), stored(&stored), implied(&implied) {}
+        Edge<E> operator[](size_t const i) const;
+        int getTargetIndex(size_t const i) const;
+        size_t size() const { return stored->size() + implied->size(); }
+        size_t getNumStored() const { return stored->size(); }
+        bool empty() const { return size() == 0; }
+        Iterator begin() const { return Iterator(this, 0); }
+        Iterator end() const { return Iterator(this, size()); }
+};
+
+/* Disjoint-set forest over the elements 0..size-1, with union by rank and path compression */
+class DisjointSet {
+    private:
+        std::vector<int> parents;
+        std::vector<unsigned char> ranks;
+        int numSets = 0;
+    public:
+        DisjointSet(int const size = 0);
+        int add();
+        int find(int element);
+        bool unite(int const a, int const b);
+        bool connected(int const a, int const b);
+        int getNumSets() const;
+        int getSize() const;
+};
+
+/* Read-only array that either owns its elements or borrows them from memory kept alive elsewhere (a mapped file) */
+template <typename T>
+class CsrArray {
+    private:
+        std::vector<T> owned;
+        T const* elements = nullptr;    //owned.data() when owning
+        size_t length = 0;
+    public:
+        CsrArray() = default;
+        CsrArray(std::vector<T>&& values) : owned(std::move(values)), elements(owned.data()), length(owned.size()) {}
+        CsrArray(T const* const elements, size_t const length) : elements(elements), length(length) {}
+        CsrArray(CsrArray<T> const& other);
+        CsrArray(CsrArray<T>&& other) noexcept;
+        CsrArray<T>& operator=(CsrArray<T> other) noexcept;
+        T const& operator[](size_t const i) const { return elements[i]; }
+        T const* data() const { return elements; }
+        T const* begin() const { return elements; }
+        T const* end() const { return elements + length; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        bool isOwner() const { return elements == owned.data(); }
+};
+
+//Code of a cost type in the binary files: its size, plus 256 for floating point types
+template <typename T>
+constexpr uint32_t binaryTypeCode() {
+    return sizeof(T) | (std::is_floating_point_v<T> << 8);
+}
+
+template <typename N, typename E>
+class CsrGraph;
+
+template <typename E>
+class Path;
+
+/* A graph whose storage (nodes, adjacency lists, edges, id lookup) is allocated from a memory resource, the default one
+   unless another is given: with a std::pmr::monotonic_buffer_resource it comes from a few large blocks, all given back
+   when the resource is, with no free per list. The resource must outlive the graph; copies use the default resource.
+   Every edge is stored once, packed (see PackedEdges); the adjacency lists hold its position */
 template <typename N, typename E>
 class Graph {
     private:
-        std::unordered_map<int,Node<N,E>> nodes;
-        std::vector<Edge<E>> edges;
+        std::pmr::vector<Node<N,E>> nodes;          //dense storage: the node with index i is nodes[i]
+        std::pmr::unordered_map<int,int> indices;   //node id -> index, stable since nodes are never removed
+        PackedEdges<E> edges;                       //in insertion order, between node indices
         unsigned int num_edges;
         unsigned int num_nodes;
+        DisjointSet components;                     //over the node indices, joined by every edge whatever its direction
+        std::pmr::vector<std::pmr::vector<unsigned int>> outgoingEdges;   //node index -> positions in edges of the edges added from it
+        std::pmr::vector<std::pmr::vector<unsigned int>> impliedEdges;    //node index -> positions in edges of the bidirectional edges ending there
+        unsigned int num_directed_edges = 0;
     public:
         Graph(unsigned int const num_edges = 0, unsigned int const num_nodes = 0) : num_edges(num_edges), num_nodes(num_nodes) {};
+        explicit Graph(std::pmr::memory_resource* const resource)
+            : nodes(resource), indices(resource), edges(resource), num_edges(0), num_nodes(0), outgoingEdges(resource), impliedEdges(resource) {};
+        std::pmr::memory_resource* getResource() const;
         Node<N,E> const& getNode(int const id) const;
         Node<N,E> & getNode(int const id);
         int getNumNodes() const;
         int getNumEdges() const;
-        std::vector<Node<N,E>> const getNodes() const;
-        std::vector<Edge<E>> const& getEdges() const;
+        int getNumComponents() const;
+        unsigned int getNumDirectedEdges() const;
+        std::pmr::vector<Node<N,E>> const& getNodes() const;
+        EdgeView<N,E> getEdges() const;
+        Edge<E> getEdge(unsigned int const position) const;
+        PackedEdges<E> const& getPackedEdges() const;
+        AdjacencyView<N,E> getAdjacency(int const id) const;
+        bool hasNode(int const id) const;
+        int getIndex(int const id) const;
+        int getId(int const index) const;
         bool addNode(Node<N,E> const& node);
         void addEdge(int const fromId, int const toId, E const cost, bool const bidirectional);
+        int addNodes(std::vector<Node<N,E>>&& newNodes);
+        void addEdges(std::vector<Edge<E>> const& newEdges);
+        CsrGraph<N,E> const freeze() const;
+    friend class CsrGraph<N,E>;
+};
+
+/* Immutable compressed sparse row snapshot of a Graph, meant for read-only algorithm runs.
+   Nodes are addressed by a dense index (0..n-1) instead of their id; the outgoing arcs of
+   the node with index i are the ones in [arcsBegin(i), arcsEnd(i)). Bidirectional edges are
+   stored once per direction, so the snapshot is already "direct" (see myGraphUtils::makeDirect).
+   A snapshot saved with save can be mapped back with map: its arrays are then read straight from the file pages */
+template <typename N, typename E>
+class CsrGraph {
+    private:
+        CsrArray<int> ids;                      //index -> node id
+        CsrArray<int> byId;                     //the indices sorted by node id, for the id -> index lookups
+        CsrArray<N> nodeCosts;
+        CsrArray<float> coords;                 //structure of arrays: coordinate d of the node with index i is coords[d * n + i]
+        unsigned int dim = 0;
+        CsrArray<unsigned int> offsets;         //n + 1 entries
+        CsrArray<int> targets;                  //target index of each arc
+        CsrArray<E> costs;
+        CsrArray<unsigned char> flags;          //BIDIRECTIONAL, REVERSED
+        unsigned int num_edges = 0;
+        unsigned int num_directed_edges = 0;
+        int num_components = 0;
+        E min_cost = 0, max_cost = 0;           //over the arcs, both 0 without arcs
+        std::shared_ptr<void const> storage;    //the mapped file the arrays borrow from, if any
+        static constexpr unsigned char BIDIRECTIONAL = 1, REVERSED = 2;
+        static constexpr uint32_t MAGIC = 0x42474c47; //"GLGB"
+        static constexpr uint32_t VERSION = 3;
+        static constexpr size_t HEADER_SIZE = 128, NUM_SECTIONS = 8, ALIGNMENT = 64;
+        static CsrArray<int> sortById(CsrArray<int> const& ids);
+        bool isValid() const;
+        void summarizeCosts();
+    public:
+        CsrGraph() = default;
+        explicit CsrGraph(Graph<N,E> const& graph);
+        bool save(std::string const& filename) const;
+        static std::optional<CsrGraph<N,E>> map(std::string const& filename);
+        bool isMapped() const;
+        int getNumNodes() const;
+        int getNumEdges() const;
+        int getNumComponents() const;
+        unsigned int getNumDirectedEdges() const;
+        unsigned int getNumArcs() const;
+        unsigned int getDimensions() const;
+        bool hasNode(int const id) const;
+        int getIndex(int const id) const;
+        int getId(int const index) const;
+        CsrArray<int> const& getIds() const;
+        N getNodeCost(int const index) const;
+        float getCoord(int const index, unsigned int const d) const;
+        float const* getAxis(unsigned int const d) const;
+        Node<N,E> makeNode(int const index) const;
+        unsigned int arcsBegin(int const index) const;
+        unsigned int arcsEnd(int const index) const;
+        int getSource(unsigned int const arc) const;
+        int getTarget(unsigned int const arc) const;
+        E getCost(unsigned int const arc) const;
+        E getMinCost() const;
+        E getMaxCost() const;
+        bool hasUniformCost() const;
+        bool isBidirectional(unsigned int const arc) const;
+        bool isReversed(unsigned int const arc) const;
+        Edge<E> makeEdge(unsigned int const arc) const;
+        Path<E> makePath(int const from, std::vector<unsigned int> const& arcs) const;
+        CsrGraph<N,E> const reversed() const;
+        CsrGraph<N,E> const reweighted(std::vector<E> const& potentials) const;
+};
+
+/* All-pairs shortest paths stored as two row-major n x n matrices over the dense node indices:
+   the distance between every pair and the next hop (index) on the path, -1 if the pair is not connected.
+   Unreachable pairs have a distance of std::numeric_limits<E>::max() */
+template <typename E>
+class PathMatrix {
+    private:
+        std::vector<int> ids;
+        std::unordered_map<int,int> indices;
+        std::vector<E> distances;
+        std::vector<int> next;
+    public:
+        PathMatrix() = default;
+        PathMatrix(std::vector<int> const& ids, std::vector<E>&& distances, std::vector<int>&& next);
+        int getNumNodes() const;
+        int getIndex(int const id) const;
+        int getId(int const index) const;
+        bool isReachable(int const fromId, int const toId) const;
+        E getDistance(int const fromId, int const toId) const;
+        int getNextHop(int const fromId, int const toId) const;
+        std::vector<int> getPath(int const fromId, int const toId) const;
+        std::vector<E> const& getDistances() const;
+        std::vector<int> const& getNextHops() const;
+        template <typename N>
+        Graph<N,E> toGraph(CsrGraph<N,E> const& graph) const;
+        template <typename N>
+        Graph<N,E> toGraph(Graph<N,E> const& graph) const;
+};
+
+template <typename E>
+class DijkstraWorkspace;
+
+template <typename E>
+class BFSWorkspace;
+
+template <typename E>
+class DialWorkspace;
+
+/* Distances between a few landmark nodes and every node, for the lower bounds of ALT searches (A*, Landmarks,
+   Triangle inequality). They are stored node-major, so the bounds of a node read one contiguous block; when the
+   graph has no one-way edges the distances to and from a landmark are the same, and only one set is kept */
+template <typename E>
+class LandmarkTable {
+    private:
+        std::vector<int> landmarks;
+        bool symmetric = true;
+        std::vector<E> fromLandmarks;   //node * numLandmarks + landmark
+        std::vector<E> toLandmarks;     //empty if symmetric
+    public:
+        LandmarkTable() = default;
+        LandmarkTable(std::vector<int> const& landmarks, std::vector<E>&& fromLandmarks, std::vector<E>&& toLandmarks);
+        int getNumLandmarks() const;
+        std::vector<int> const& getLandmarks() const;
+        bool isSymmetric() const;
+        E lowerBound(int const fromIndex, int const toIndex) const;
+};
+
+/* Single source shortest paths as flat arrays over the dense node indices: the distance of every node from
+   the source and the node (and arc) preceding it on its path, -1 for the source and unreached nodes.
+   Unreached nodes have a distance of std::numeric_limits<E>::max() */
+template <typename E>
+class ShortestPathTree {
+    private:
+        int source = -1;
+        std::vector<E> distances;
+        std::vector<int> predecessors;
+        std::vector<unsigned int> arcs;
+        std::vector<bool> settled;
+    public:
+        ShortestPathTree() = default;
+        ShortestPathTree(int const source, std::vector<E>&& distances, std::vector<int>&& predecessors, std::vector<unsigned int>&& arcs);
+        ShortestPathTree(int const source, std::vector<E>&& distances, std::vector<int>&& predecessors, std::vector<unsigned int>&& arcs,
+                         std::vector<bool>&& settled);
+        int getSource() const;
+        int getNumNodes() const;
+        bool isReachable(int const index) const;
+        bool isSettled(int const index) const;
+        E getDistance(int const index) const;
+        int getPredecessor(int const index) const;
+        unsigned int getPredecessorArc(int const index) const;
+        std::vector<int> getPath(int const index) const;
+        std::vector<E> const& getDistances() const;
+        std::vector<int> const& getPredecessors() const;
+    friend class DijkstraWorkspace<E>;
+    friend class BFSWorkspace<E>;
+    friend class DialWorkspace<E>;
+};
+
+/* The result of a breadth first search over the dense node indices: the level (number of edges from the source) and
+   the parent of every node, -1 for unreached nodes and for the parent of the source */
+class BreadthFirstTree {
+    private:
+        int source = -1;
+        std::vector<int> levels;
+        std::vector<int> parents;
+        int numReached = 0;
+    public:
+        BreadthFirstTree() = default;
+        BreadthFirstTree(int const source, std::vector<int>&& levels, std::vector<int>&& parents);
+        int getSource() const;
+        int getNumNodes() const;
+        int getNumReached() const;
+        bool isReachable(int const index) const;
+        int getLevel(int const index) const;
+        int getParent(int const index) const;
+        std::vector<int> getPath(int const index) const;
+        std::vector<int> const& getLevels() const;
+        std::vector<int> const& getParents() const;
+};
+
+/* The connected components of a graph (weak ones, if it has one-way edges) as a label per dense node index.
+   Labels go from 0 to getNumComponents() - 1, numbered in the order of the first index of each component */
+class ComponentLabels {
+    private:
+        std::vector<int> labels;
+        std::vector<int> sizes;
+    public:
+        ComponentLabels() = default;
+        ComponentLabels(std::vector<int>&& labels, int const numComponents);
+        int getNumNodes() const;
+        int getNumComponents() const;
+        int getComponent(int const index) const;
+        int getSize(int const component) const;
+        std::vector<int> const& getLabels() const;
+};
+
+/* A path as the ids of its nodes, from the start to the end, and the cost and bidirectional flag of every edge along it
+   (one less than the nodes): what the point to point searches return. toGraph builds the Graph form when it is needed */
+template <typename E>
+class Path {
+    private:
+        std::vector<int> nodes;
+        std::vector<E> costs;           //costs[i] is the cost of the edge from nodes[i] to nodes[i + 1]
+        std::vector<bool> bidirectional;
+        E cost = 0;
+    public:
+        Path() = default;
+        Path(std::vector<int>&& nodes, std::vector<E>&& costs, std::vector<bool>&& bidirectional);
+        int getNumNodes() const;
+        int getFrom() const;
+        int getTo() const;
+        E getCost() const;
+        std::vector<int> const& getNodes() const;
+        std::vector<E> const& getCosts() const;
+        bool isBidirectional(size_t const edge) const;
+        template <typename N>
+        Graph<N,E> toGraph(CsrGraph<N,E> const& graph) const;
+        template <typename N>
+        Graph<N,E> toGraph(Graph<N,E> const& graph) const;
+};
+
+/* A spanning tree as a parent array over the dense node indices of its graph: the parent of every node, -1 for the root,
+   and the cost and bidirectional flag of the edge joining them, which goes from the parent to the node.
+   toGraph builds the Graph form when it is needed */
+template <typename E>
+class SpanningTree {
+    private:
+        std::vector<int> parents;
+        std::vector<E> costs;
+        std::vector<bool> bidirectional;
+        E cost = 0;
+    public:
+        SpanningTree() = default;
+        SpanningTree(std::vector<int>&& parents, std::vector<E>&& costs, std::vector<bool>&& bidirectional);
+        int getNumNodes() const;
+        int getParent(int const index) const;
+        E getEdgeCost(int const index) const;
+        bool isBidirectional(int const index) const;
+        E getCost() const;
+        std::vector<int> const& getParents() const;
+        template <typename N>
+        Graph<N,E> toGraph(CsrGraph<N,E> const& graph) const;
+        template <typename N>
+        Graph<N,E> toGraph(Graph<N,E> const& graph) const;
 };
 
 template <typename N, typename E>
-std::vector<float> const& Node<N,E>::getCoords() const {
+Coords const& Node<N,E>::getCoords() const {
     return this->coords;
 }
 
+inline void Coords::assign(float const* const values, unsigned int const size) {
+    if(size > INLINE_COORDS) {
+        if(!spilled || count < size) {
+            spilled.reset(new float[size]);
+        }
+    } else {
+        spilled.reset();
+    }
+    count = size;
+    std::copy(values, values + size, spilled ? spilled.get() : local);
+}
+
+inline Coords::Coords(Coords&& other) noexcept : count(other.count), spilled(std::move(other.spilled)) {
+    std::copy(other.local, other.local + INLINE_COORDS, local);
+    other.count = 0;
+}
+
+inline Coords& Coords::operator=(Coords const& other) {
+    if(this != &other) {
+        assign(other.data(), other.count);
+    }
+    return *this;
+}
+
+inline Coords& Coords::operator=(Coords&& other) noexcept {
+    std::copy(other.local, other.local + INLINE_COORDS, local);
+    count = other.count;
+    spilled = std::move(other.spilled);
+    other.count = 0;
+    return *this;
+}
+
+inline DisjointSet::DisjointSet(int const size) : parents(size), ranks(size, 0), numSets(size) {
+    for (int i = 0; i < size; i++) {
+        parents[i] = i;
+    }
+}
+
+//Adds a new singleton set and returns its element
+inline int DisjointSet::add() {
+    parents.push_back(parents.size());
+    ranks.push_back(0);
+    numSets++;
+    return parents.size() - 1;
+}
+
+//Returns the representative of the set of element, halving the path to it on the way
+inline int DisjointSet::find(int element) {
+    while(parents[element] != element) {
+        parents[element] = parents[parents[element]];
+        element = parents[element];
+    }
+    return element;
+}
+
+//Merges the sets of a and b, returns false if they already were the same set
+inline bool DisjointSet::unite(int const a, int const b) {
+    int rootA = find(a), rootB = find(b);
+    if(rootA == rootB) {
+        return false;
+    }
+    if(ranks[rootA] < ranks[rootB]) {
+        std::swap(rootA, rootB);
+    }
+    parents[rootB] = rootA;
+    if(ranks[rootA] == ranks[rootB]) {
+        ranks[rootA]++;
+    }
+    numSets--;
+    return true;
+}
+
+inline bool DisjointSet::connected(int const a, int const b) {
+    return find(a) == find(b);
+}
+
+inline int DisjointSet::getNumSets() const {
+    return numSets;
+}
+
+inline int DisjointSet::getSize() const {
+    return parents.size();
+}
+
+template <typename E, typename I>
+void PackedEdges<E,I>::push_back(I const source, I const target, E const cost, bool const bidirectional) {
+    sources.push_back(source);
+    targets.push_back(target | (bidirectional ? BIDIRECTIONAL : 0));
+    costs.push_back(cost);
+}
+
+template <typename E, typename I>
+void PackedEdges<E,I>::reserve(size_t const count) {
+    sources.reserve(count);
+    targets.reserve(count);
+    costs.reserve(count);
+}
+
+//Returns the memory taken by the arrays, reserved space included
+template <typename E, typename I>
+size_t PackedEdges<E,I>::getBytes() const {
+    return (sources.capacity() + targets.capacity()) * sizeof(I) + costs.capacity() * sizeof(E);
+}
+
+template <typename N, typename E>
+Edge<E> EdgeView<N,E>::operator[](size_t const position) const {
+    return graph->getEdge(position);
+}
+
+template <typename N, typename E>
+size_t EdgeView<N,E>::size() const {
+    return graph->getPackedEdges().size();
+}
+
+template <typename N, typename E>
+Edge<E> AdjacencyView<N,E>::operator[](size_t const i) const {
+    if(i < stored->size()) {
+        return graph->getEdge((*stored)[i]);
+    }
+    Edge<E> const edge = graph->getEdge((*implied)[i - stored->size()]);
+    return Edge<E>(edge.getTo(), edge.getFrom(), edge.getCost(), edge.isBidirectional());
+}
+
+//Returns the index of the node the i-th edge leads to, without building the edge nor loading its cost
+template <typename N, typename E>
+int AdjacencyView<N,E>::getTargetIndex(size_t const i) const {
+    PackedEdges<E> const& edges = graph->getPackedEdges();
+    return i < stored->size() ? edges.getTarget((*stored)[i]) : edges.getSource((*implied)[i - stored->size()]);
+}
+
 template <typename E>
 bool Edge<E>::operator<(Edge<E> const& other) const {
     return this->cost < other.cost;
@@ -129,12 +704,17 @@ bool const Edge<E>::isBidirectional() const{
 
 template <typename N, typename E>
 Node<N,E> const& Graph<N,E>::getNode(int const id) const{
-    return nodes.at(id);
+    return nodes[indices.at(id)];
 }
 
 template <typename N, typename E>
 Node<N,E> & Graph<N,E>::getNode(int const id) {
-    return nodes.at(id);
+    return nodes[indices.at(id)];
+}
+
+template <typename N, typename E>
+std::pmr::memory_resource* Graph<N,E>::getResource() const {
+    return nodes.get_allocator().resource();
 }
 
 template <typename N, typename E>
@@ -147,40 +727,1068 @@ int Graph<N,E>::getNumEdges() const {
     return this->num_edges;
 }
 
+//Returns the number of weakly connected components (edges joining their ends in both directions), kept up to date by addNode and addEdge
+template <typename N, typename E>
+int Graph<N,E>::getNumComponents() const {
+    return components.getNumSets();
+}
+
+//Returns the number of edges that are not bidirectional: the graph is direct if there is at least one
+template <typename N, typename E>
+unsigned int Graph<N,E>::getNumDirectedEdges() const {
+    return num_directed_edges;
+}
+
 
 template <typename N, typename E>
 void Graph<N,E>::addEdge(int const fromId, int const toId, E const cost, bool const bidirectional) {
-    Node<N,E> & from = this->getNode(fromId), &to = this->getNode(toId);
-    Edge<E> const edge(fromId, toId, cost, bidirectional);
-    from.addAdjacentEdge(edge);
-    edges.push_back(edge);
+    int const from = indices.at(fromId), to = indices.at(toId);
+    outgoingEdges[from].push_back(edges.size());
+    if(bidirectional && from != to) {
+        impliedEdges[to].push_back(edges.size());
+    }
+    edges.push_back(from, to, cost, bidirectional);
     num_edges++;
+    num_directed_edges += !bidirectional;
+    components.unite(from, to);
 };
 
 template <typename N, typename E>
 bool Graph<N,E>::addNode(Node<N,E> const& node) {
-    bool const inserted = this->nodes.try_emplace(node.getId(), node).second;
+    bool const inserted = this->indices.try_emplace(node.getId(), nodes.size()).second;
     if(inserted) {
+        nodes.push_back(node);
+        outgoingEdges.emplace_back();
+        impliedEdges.emplace_back();
+        components.add();
         num_nodes++;
     }
     return inserted;
 };
 
+//Adds the nodes whose id is not in the graph yet, like addNode, and returns how many were added
 template <typename N, typename E>
-std::vector<Node<N,E>> const Graph<N,E>::getNodes() const {
-    std::vector<Node<N,E>> result;
-    //result.reserve(this->num_nodes * sizeof(Node<N,E>));
-    for (auto const& pair : this->nodes) {
-        result.push_back(pair.second);
+int Graph<N,E>::addNodes(std::vector<Node<N,E>>&& newNodes) {
+    nodes.reserve(nodes.size() + newNodes.size());
+    indices.reserve(indices.size() + newNodes.size());
+    int added = 0;
+    for (Node<N,E>& node : newNodes) {
+        if(indices.try_emplace(node.getId(), nodes.size()).second) {
+            nodes.push_back(std::move(node));
+            outgoingEdges.emplace_back();
+            impliedEdges.emplace_back();
+            components.add();
+            added++;
+        }
     }
+    num_nodes += added;
+    return added;
+}
 
-    return result;
+/* Adds all the edges at once, growing every adjacency list a single time.
+   Like addEdge, it throws std::out_of_range if an end node is missing, in which case nothing is added */
+template <typename N, typename E>
+void Graph<N,E>::addEdges(std::vector<Edge<E>> const& newEdges) {
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<int> from(newEdges.size(), scratch), to(newEdges.size(), scratch);
+    ScratchVector<unsigned int> degrees(nodes.size(), 0, scratch);
+    for (size_t i = 0; i < newEdges.size(); i++) {
+        from[i] = indices.at(newEdges[i].getFrom());
+        to[i] = indices.at(newEdges[i].getTo());
+        degrees[from[i]]++;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if(degrees[i] > 0) {
+            outgoingEdges[i].reserve(outgoingEdges[i].size() + degrees[i]);
+        }
+    }
+    edges.reserve(edges.size() + newEdges.size());
+    for (size_t i = 0; i < newEdges.size(); i++) {
+        Edge<E> const& edge = newEdges[i];
+        outgoingEdges[from[i]].push_back(edges.size());
+        if(edge.isBidirectional() && from[i] != to[i]) {
+            impliedEdges[to[i]].push_back(edges.size());
+        }
+        edges.push_back(from[i], to[i], edge.getCost(), edge.isBidirectional());
+        num_directed_edges += !edge.isBidirectional();
+        components.unite(from[i], to[i]);
+    }
+    num_edges += newEdges.size();
+}
+
+template <typename N, typename E>
+std::pmr::vector<Node<N,E>> const& Graph<N,E>::getNodes() const {
+    return nodes;
+}
+
+//Returns all the edges, in the order they were added; they are built on access, see EdgeView
+template <typename N, typename E>
+EdgeView<N,E> Graph<N,E>::getEdges() const {
+    return EdgeView<N,E>(*this);
+}
+
+//Returns the edge added at the given position (0..getNumEdges()-1)
+template <typename N, typename E>
+Edge<E> Graph<N,E>::getEdge(unsigned int const position) const {
+    return Edge<E>(nodes[edges.getSource(position)].getId(), nodes[edges.getTarget(position)].getId(),
+                   edges.getCost(position), edges.isBidirectional(position));
 }
 
+//Returns the edge storage itself, whose ends are node indices
 template <typename N, typename E>
-std::vector<Edge<E>> const& Graph<N,E>::getEdges() const {
+PackedEdges<E> const& Graph<N,E>::getPackedEdges() const {
     return edges;
 }
 
+//Returns the edges leaving the node, the implied reverse of its incoming bidirectional edges included, see AdjacencyView
+template <typename N, typename E>
+AdjacencyView<N,E> Graph<N,E>::getAdjacency(int const id) const {
+    int const index = indices.at(id);
+    return AdjacencyView<N,E>(*this, outgoingEdges[index], impliedEdges[index]);
+}
+
+template <typename N, typename E>
+bool Graph<N,E>::hasNode(int const id) const {
+    return indices.find(id) != indices.end();
+}
+
+//Returns the dense index (0..n-1) of the node, which is the position it was inserted at
+template <typename N, typename E>
+int Graph<N,E>::getIndex(int const id) const {
+    return indices.at(id);
+}
+
+template <typename N, typename E>
+int Graph<N,E>::getId(int const index) const {
+    return nodes[index].getId();
+}
+
+template <typename N, typename E>
+CsrGraph<N,E> const Graph<N,E>::freeze() const {
+    return CsrGraph<N,E>(*this);
+}
+
+template <typename T>
+CsrArray<T>::CsrArray(CsrArray<T> const& other)
+    : owned(other.owned), elements(other.isOwner() ? owned.data() : other.elements), length(other.length) {}
+
+//Moving a vector keeps its buffer, so the elements stay where they are
+template <typename T>
+CsrArray<T>::CsrArray(CsrArray<T>&& other) noexcept
+    : owned(std::move(other.owned)), elements(other.elements), length(other.length) {
+    other.elements = nullptr;
+    other.length = 0;
+}
+
+template <typename T>
+CsrArray<T>& CsrArray<T>::operator=(CsrArray<T> other) noexcept {
+    owned.swap(other.owned);
+    std::swap(elements, other.elements);
+    std::swap(length, other.length);
+    return *this;
+}
+
+//The snapshot keeps the dense indices of the graph
+template <typename N, typename E>
+CsrGraph<N,E>::CsrGraph(Graph<N,E> const& graph)
+    : num_edges(graph.getNumEdges()), num_directed_edges(graph.getNumDirectedEdges()), num_components(graph.getNumComponents()) {
+    int const n = graph.nodes.size();
+    std::vector<int> nodeIds;
+    std::vector<N> nodeCosts;
+    std::vector<float> coords;
+    nodeIds.reserve(n);
+    nodeCosts.reserve(n);
+    if(n > 0) {
+        dim = graph.nodes.front().getCoords().size();
+    }
+    coords.assign((size_t)n * dim, 0.0f);
+    PackedEdges<E> const& edges = graph.edges;
+    //Counting sort of the arcs by source index: first the degrees, then the prefix sums
+    std::vector<unsigned int> offsets(n + 1, 0);
+    for (int i = 0; i < n; i++) {
+        Node<N,E> const& node = graph.nodes[i];
+        nodeIds.push_back(node.getId());
+        nodeCosts.push_back(node.getCost());
+        Coords const& c = node.getCoords();
+        for (size_t d = 0; d < dim && d < c.size(); d++) {
+            coords[d * n + i] = c[d];
+        }
+        //the arcs added from the node, then the reverse of the bidirectional edges ending there
+        offsets[i + 1] = graph.outgoingEdges[i].size() + graph.impliedEdges[i].size();
+    }
+    for (int i = 0; i < n; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<int> targets(offsets[n]);
+    std::vector<E> costs(offsets[n]);
+    std::vector<unsigned char> flags(offsets[n]);
+    std::vector<unsigned int> next(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < n; i++) {
+        for (unsigned int const e : graph.outgoingEdges[i]) {
+            int const to = edges.getTarget(e);
+            unsigned char const bidir = edges.isBidirectional(e) ? BIDIRECTIONAL : 0;
+            unsigned int arc = next[i]++;
+            targets[arc] = to;
+            costs[arc] = edges.getCost(e);
+            flags[arc] = bidir;
+            if(bidir && i != to) {
+                arc = next[to]++;
+                targets[arc] = i;
+                costs[arc] = edges.getCost(e);
+                flags[arc] = bidir | REVERSED;
+            }
+        }
+    }
+    this->ids = std::move(nodeIds);
+    this->byId = sortById(this->ids);
+    this->nodeCosts = std::move(nodeCosts);
+    this->coords = std::move(coords);
+    this->offsets = std::move(offsets);
+    this->targets = std::move(targets);
+    this->costs = std::move(costs);
+    this->flags = std::move(flags);
+    summarizeCosts();
+}
+
+template <typename N, typename E>
+CsrArray<int> CsrGraph<N,E>::sortById(CsrArray<int> const& ids) {
+    std::vector<int> order(ids.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&ids](int const a, int const b) { return ids[a] < ids[b]; });
+    return CsrArray<int>(std::move(order));
+}
+
+/* Saves the snapshot in the binary graph format (see graph_schema.txt): a fixed size header followed by one section
+   per array, each starting at a multiple of 64 bytes. Numbers are stored in the byte order of the machine writing them
+    Returns: whether the file could be written */
+template <typename N, typename E>
+bool CsrGraph<N,E>::save(std::string const& filename) const {
+    static_assert(std::is_trivially_copyable_v<N> && std::is_trivially_copyable_v<E>, "binary graphs need trivially copyable costs");
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+    struct Section {
+        void const* data;
+        size_t bytes;
+    };
+    Section const sections[NUM_SECTIONS] = {
+        {ids.data(), ids.size() * sizeof(int)},
+        {byId.data(), byId.size() * sizeof(int)},
+        {nodeCosts.data(), nodeCosts.size() * sizeof(N)},
+        {coords.data(), coords.size() * sizeof(float)},
+        {offsets.data(), offsets.size() * sizeof(unsigned int)},
+        {targets.data(), targets.size() * sizeof(int)},
+        {costs.data(), costs.size() * sizeof(E)},
+        {flags.data(), flags.size() * sizeof(unsigned char)}
+    };
+    uint32_t const counts[8] = {MAGIC, VERSION, binaryTypeCode<N>(), binaryTypeCode<E>(), dim, (uint32_t)getNumNodes(), getNumArcs(), num_edges};
+    uint32_t const summary[2] = {num_directed_edges, (uint32_t)num_components};
+    uint64_t sectionOffsets[NUM_SECTIONS];
+    uint64_t position = HEADER_SIZE;
+    for (size_t i = 0; i < NUM_SECTIONS; i++) {
+        sectionOffsets[i] = position;
+        position = (position + sections[i].bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+    char header[HEADER_SIZE] = {};
+    std::memcpy(header, counts, sizeof(counts));
+    std::memcpy(header + sizeof(counts), sectionOffsets, sizeof(sectionOffsets));
+    std::memcpy(header + sizeof(counts) + sizeof(sectionOffsets), summary, sizeof(summary));
+    file.write(header, HEADER_SIZE);
+    char const padding[ALIGNMENT] = {};
+    //Every section is padded, the last one too, so that even empty sections lie within the file
+    for (size_t i = 0; i < NUM_SECTIONS; i++) {
+        uint64_t const next = i + 1 < NUM_SECTIONS ? sectionOffsets[i + 1] : position;
+        file.write(static_cast<char const*>(sections[i].data), sections[i].bytes);
+        file.write(padding, next - (sectionOffsets[i] + sections[i].bytes));
+    }
+    return file.good();
+}
+
+/* Maps a file written by save. Nothing is parsed or copied: the arrays of the snapshot point into the mapped pages,
+   which stay mapped as long as the snapshot (or a copy of it) is alive. The arrays are checked once (see isValid),
+   so that a corrupted or truncated file is rejected here instead of making an algorithm read out of bounds
+    Returns: an optional containing the snapshot, empty if the file can not be mapped, was not written with the same
+             node and edge cost types or is not consistent */
+template <typename N, typename E>
+std::optional<CsrGraph<N,E>> CsrGraph<N,E>::map(std::string const& filename) {
+    int const fd = open(filename.c_str(), O_RDONLY);
+    if(fd == -1) {
+        return {};
+    }
+    struct stat info;
+    if(fstat(fd, &info) == -1 || (size_t)info.st_size < HEADER_SIZE) {
+        close(fd);
+        return {};
+    }
+    size_t const size = info.st_size;
+    void* const address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(address == MAP_FAILED) {
+        return {};
+    }
+    CsrGraph<N,E> graph;
+    graph.storage = std::shared_ptr<void const>(address, [size](void const* a) { munmap(const_cast<void*>(a), size); });
+    char const* const bytes = static_cast<char const*>(address);
+    uint32_t counts[8], summary[2];
+    uint64_t sectionOffsets[NUM_SECTIONS];
+    std::memcpy(counts, bytes, sizeof(counts));
+    std::memcpy(sectionOffsets, bytes + sizeof(counts), sizeof(sectionOffsets));
+    std::memcpy(summary, bytes + sizeof(counts) + sizeof(sectionOffsets), sizeof(summary));
+    if(counts[0] != MAGIC || counts[1] != VERSION || counts[2] != binaryTypeCode<N>() || counts[3] != binaryTypeCode<E>()) {
+        return {};
+    }
+    size_t const n = counts[5], m = counts[6];
+    graph.dim = counts[4];
+    graph.num_edges = counts[7];
+    graph.num_directed_edges = summary[0];
+    graph.num_components = summary[1];
+    //Checks that the section lies within the file and is aligned, then points the array at it
+    bool valid = true;
+    auto bind = [&](auto& array, size_t const section, size_t const count) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(array.data())>>;
+        uint64_t const offset = sectionOffsets[section];
+        if(offset % ALIGNMENT != 0 || offset > size || count > (size - offset) / sizeof(T)) {
+            valid = false;
+            return;
+        }
+        array = CsrArray<T>(reinterpret_cast<T const*>(bytes + offset), count);
+    };
+    bind(graph.ids, 0, n);
+    bind(graph.byId, 1, n);
+    bind(graph.nodeCosts, 2, n);
+    bind(graph.coords, 3, n * graph.dim);
+    bind(graph.offsets, 4, n + 1);
+    bind(graph.targets, 5, m);
+    bind(graph.costs, 6, m);
+    bind(graph.flags, 7, m);
+    if(!valid || !graph.isValid()) {
+        return {};
+    }
+    graph.summarizeCosts();
+    return {graph};
+}
+
+/* Tells whether the arrays of a mapped snapshot are consistent, so that the algorithms stay in bounds: the offsets
+   go from 0 to the number of arcs without going down, every target is a node index, and byId is a permutation of
+   the indices sorting the ids, which are all different. It reads every array once, O(n + m) */
+template <typename N, typename E>
+bool CsrGraph<N,E>::isValid() const {
+    size_t const n = ids.size(), m = targets.size();
+    if(offsets.size() != n + 1 || byId.size() != n || offsets[0] != 0 || offsets[n] != m) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if(offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+    for (int const target : targets) {
+        if(target < 0 || (size_t)target >= n) {
+            return false;
+        }
+    }
+    std::vector<bool> seen(n, false);
+    for (size_t i = 0; i < n; i++) {
+        int const index = byId[i];
+        if(index < 0 || (size_t)index >= n || seen[index] || (i > 0 && ids[byId[i - 1]] >= ids[index])) {
+            return false;
+        }
+        seen[index] = true;
+    }
+    return true;
+}
+
+/* Reads the smallest and largest arc costs once, so that the algorithms picking an engine or sizing their buckets
+   from them do not have to scan the arcs on every call */
+template <typename N, typename E>
+void CsrGraph<N,E>::summarizeCosts() {
+    min_cost = max_cost = costs.size() > 0 ? costs[0] : E(0);
+    for (E const cost : costs) {
+        min_cost = std::min(min_cost, cost);
+        max_cost = std::max(max_cost, cost);
+    }
+}
+
+template <typename N, typename E>
+bool CsrGraph<N,E>::isMapped() const {
+    return storage != nullptr;
+}
+
+template <typename N, typename E>
+int CsrGraph<N,E>::getNumNodes() const {
+    return ids.size();
+}
+
+template <typename N, typename E>
+int CsrGraph<N,E>::getNumEdges() const {
+    return num_edges;
+}
+
+//Returns the number of weakly connected components of the graph the snapshot was taken from
+template <typename N, typename E>
+int CsrGraph<N,E>::getNumComponents() const {
+    return num_components;
+}
+
+template <typename N, typename E>
+unsigned int CsrGraph<N,E>::getNumDirectedEdges() const {
+    return num_directed_edges;
+}
+
+template <typename N, typename E>
+unsigned int CsrGraph<N,E>::getNumArcs() const {
+    return targets.size();
+}
+
+template <typename N, typename E>
+unsigned int CsrGraph<N,E>::getDimensions() const {
+    return dim;
+}
+
+template <typename N, typename E>
+bool CsrGraph<N,E>::hasNode(int const id) const {
+    auto const it = std::lower_bound(byId.begin(), byId.end(), id, [this](int const index, int const id) { return ids[index] < id; });
+    return it != byId.end() && ids[*it] == id;
+}
+
+//Binary search over the indices sorted by id; like Graph::getIndex, it throws std::out_of_range for unknown ids
+template <typename N, typename E>
+int CsrGraph<N,E>::getIndex(int const id) const {
+    auto const it = std::lower_bound(byId.begin(), byId.end(), id, [this](int const index, int const id) { return ids[index] < id; });
+    if(it == byId.end() || ids[*it] != id) {
+        throw std::out_of_range("no node with id " + std::to_string(id));
+    }
+    return *it;
+}
+
+template <typename N, typename E>
+int CsrGraph<N,E>::getId(int const index) const {
+    return ids[index];
+}
+
+template <typename N, typename E>
+CsrArray<int> const& CsrGraph<N,E>::getIds() const {
+    return ids;
+}
+
+template <typename N, typename E>
+N CsrGraph<N,E>::getNodeCost(int const index) const {
+    return nodeCosts[index];
+}
+
+template <typename N, typename E>
+float CsrGraph<N,E>::getCoord(int const index, unsigned int const d) const {
+    return coords[(size_t)d * ids.size() + index];
+}
+
+//Returns the coordinate d of every node, by index: contiguous, so that kernels over many nodes vectorize
+template <typename N, typename E>
+float const* CsrGraph<N,E>::getAxis(unsigned int const d) const {
+    return coords.data() + (size_t)d * ids.size();
+}
+
+template <typename N, typename E>
+Node<N,E> CsrGraph<N,E>::makeNode(int const index) const {
+    float c[INLINE_COORDS];
+    std::vector<float> spilled(dim > INLINE_COORDS ? dim : 0);
+    float* const values = dim > INLINE_COORDS ? spilled.data() : c;
+    for (unsigned int d = 0; d < dim; d++) {
+        values[d] = getCoord(index, d);
+    }
+    return Node<N,E>(ids[index], Coords(values, dim), nodeCosts[index]);
+}
+
+template <typename N, typename E>
+unsigned int CsrGraph<N,E>::arcsBegin(int const index) const {
+    return offsets[index];
+}
+
+template <typename N, typename E>
+unsigned int CsrGraph<N,E>::arcsEnd(int const index) const {
+    return offsets[index + 1];
+}
+
+template <typename N, typename E>
+int CsrGraph<N,E>::getSource(unsigned int const arc) const {
+    return std::upper_bound(offsets.begin(), offsets.end(), arc) - offsets.begin() - 1;
+}
+
+template <typename N, typename E>
+int CsrGraph<N,E>::getTarget(unsigned int const arc) const {
+    return targets[arc];
+}
+
+template <typename N, typename E>
+E CsrGraph<N,E>::getCost(unsigned int const arc) const {
+    return costs[arc];
+}
+
+//Returns the smallest arc cost, 0 without arcs
+template <typename N, typename E>
+E CsrGraph<N,E>::getMinCost() const {
+    return min_cost;
+}
+
+//Returns the largest arc cost, 0 without arcs
+template <typename N, typename E>
+E CsrGraph<N,E>::getMaxCost() const {
+    return max_cost;
+}
+
+//Returns whether every arc has the same cost, which holds without arcs too
+template <typename N, typename E>
+bool CsrGraph<N,E>::hasUniformCost() const {
+    return min_cost == max_cost;
+}
+
+template <typename N, typename E>
+bool CsrGraph<N,E>::isBidirectional(unsigned int const arc) const {
+    return flags[arc] & BIDIRECTIONAL;
+}
+
+template <typename N, typename E>
+bool CsrGraph<N,E>::isReversed(unsigned int const arc) const {
+    return flags[arc] & REVERSED;
+}
+
+//Rebuilds the edge (with node ids) the arc comes from, oriented as the arc
+template <typename N, typename E>
+Edge<E> CsrGraph<N,E>::makeEdge(unsigned int const arc) const {
+    return Edge<E>(ids[getSource(arc)], ids[targets[arc]], costs[arc], isBidirectional(arc));
+}
+
+//Builds the path starting at the node with index "from" and following the arcs, each leaving the node the previous one reached
+template <typename N, typename E>
+Path<E> CsrGraph<N,E>::makePath(int const from, std::vector<unsigned int> const& arcs) const {
+    std::vector<int> nodes;
+    std::vector<E> costs;
+    std::vector<bool> bidirectional;
+    nodes.reserve(arcs.size() + 1);
+    costs.reserve(arcs.size());
+    nodes.push_back(ids[from]);
+    for (unsigned int const arc : arcs) {
+        nodes.push_back(ids[targets[arc]]);
+        costs.push_back(this->costs[arc]);
+        bidirectional.push_back(isBidirectional(arc));
+    }
+    return Path<E>(std::move(nodes), std::move(costs), std::move(bidirectional));
+}
+
+
+/* Returns the transpose of the snapshot: the same nodes, with every arc pointing the other way.
+   Searching it from a node finds the paths leading to that node in the original graph.
+   The node arrays are shared with a mapped snapshot rather than copied */
+template <typename N, typename E>
+CsrGraph<N,E> const CsrGraph<N,E>::reversed() const {
+    CsrGraph<N,E> result;
+    int const n = ids.size();
+    result.storage = storage;
+    result.ids = ids;
+    result.byId = byId;
+    result.nodeCosts = nodeCosts;
+    result.coords = coords;
+    result.dim = dim;
+    result.num_edges = num_edges;
+    result.num_directed_edges = num_directed_edges;
+    result.num_components = num_components;
+    result.min_cost = min_cost;
+    result.max_cost = max_cost;
+    std::vector<unsigned int> offsets(n + 1, 0);
+    for (int const target : targets) {
+        offsets[target + 1]++;
+    }
+    for (int i = 0; i < n; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<int> targets(this->targets.size());
+    std::vector<E> costs(this->costs.size());
+    std::vector<unsigned char> flags(this->flags.size());
+    std::vector<unsigned int> next(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < n; i++) {
+        for (unsigned int arc = this->offsets[i]; arc < this->offsets[i + 1]; arc++) {
+            unsigned int const reverse = next[this->targets[arc]]++;
+            targets[reverse] = i;
+            costs[reverse] = this->costs[arc];
+            flags[reverse] = this->flags[arc];
+        }
+    }
+    result.offsets = std::move(offsets);
+    result.targets = std::move(targets);
+    result.costs = std::move(costs);
+    result.flags = std::move(flags);
+    return result;
+}
+
+/* Returns a copy of the snapshot where every arc from i to j costs cost + potentials[i] - potentials[j] (Johnson's
+   reweighting): every path between two nodes changes by the same amount, so the shortest ones stay the same, and with
+   feasible potentials no cost is negative. Floating point round-off below zero is clamped to 0 */
+template <typename N, typename E>
+CsrGraph<N,E> const CsrGraph<N,E>::reweighted(std::vector<E> const& potentials) const {
+    int const n = ids.size();
+    if((int)potentials.size() != n) {
+        throw std::invalid_argument("reweighting needs one potential per node");
+    }
+    CsrGraph<N,E> result(*this);
+    std::vector<E> costs(this->costs.size());
+    for (int i = 0; i < n; i++) {
+        for (unsigned int arc = offsets[i]; arc < offsets[i + 1]; arc++) {
+            costs[arc] = std::max(E(0), this->costs[arc] + potentials[i] - potentials[targets[arc]]);
+        }
+    }
+    result.costs = std::move(costs);
+    result.summarizeCosts();
+    return result;
+}
+
+template <typename E>
+PathMatrix<E>::PathMatrix(std::vector<int> const& ids, std::vector<E>&& distances, std::vector<int>&& next)
+    : ids(ids), distances(std::move(distances)), next(std::move(next)) {
+    indices.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        indices.emplace(ids[i], i);
+    }
+}
+
+template <typename E>
+int PathMatrix<E>::getNumNodes() const {
+    return ids.size();
+}
+
+template <typename E>
+int PathMatrix<E>::getIndex(int const id) const {
+    return indices.at(id);
+}
+
+template <typename E>
+int PathMatrix<E>::getId(int const index) const {
+    return ids[index];
+}
+
+template <typename E>
+bool PathMatrix<E>::isReachable(int const fromId, int const toId) const {
+    return next[(size_t)getIndex(fromId) * ids.size() + getIndex(toId)] != -1;
+}
+
+template <typename E>
+E PathMatrix<E>::getDistance(int const fromId, int const toId) const {
+    return distances[(size_t)getIndex(fromId) * ids.size() + getIndex(toId)];
+}
+
+//Returns the id of the node following fromId on the path to toId, -1 if toId is not reachable
+template <typename E>
+int PathMatrix<E>::getNextHop(int const fromId, int const toId) const {
+    int const hop = next[(size_t)getIndex(fromId) * ids.size() + getIndex(toId)];
+    return hop == -1 ? -1 : ids[hop];
+}
+
+//Returns the ids of the nodes on the path, both ends included; empty if toId is not reachable
+template <typename E>
+std::vector<int> PathMatrix<E>::getPath(int const fromId, int const toId) const {
+    std::vector<int> path;
+    size_t const n = ids.size();
+    int const to = getIndex(toId);
+    int current = getIndex(fromId);
+    if(next[current * n + to] == -1) {
+        return path;
+    }
+    path.push_back(fromId);
+    while(current != to) {
+        current = next[current * n + to];
+        path.push_back(ids[current]);
+    }
+    return path;
+}
+
+template <typename E>
+std::vector<E> const& PathMatrix<E>::getDistances() const {
+    return distances;
+}
+
+template <typename E>
+std::vector<int> const& PathMatrix<E>::getNextHops() const {
+    return next;
+}
+
+/* Builds the graph holding, for every pair of connected nodes, the first edge of the shortest path between them:
+   the cheapest arc from the node to the next hop. The matrix must come from the same graph */
+template <typename E>
+template <typename N>
+Graph<N,E> PathMatrix<E>::toGraph(CsrGraph<N,E> const& graph) const {
+    size_t const n = graph.getNumNodes();
+    if(n != ids.size()) {
+        throw std::invalid_argument("the path matrix was computed on a different graph");
+    }
+    unsigned int const none = std::numeric_limits<unsigned int>().max();
+    ScratchVector<unsigned int> bestArc(n, none, myGraphUtils::getScratchResource()); //given a target index, the cheapest arc reaching it from the current node
+    Graph<N,E> result;
+    for (size_t i = 0; i < n; i++) {
+        result.addNode(graph.makeNode(i));
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (unsigned int arc = graph.arcsBegin(i); arc < graph.arcsEnd(i); arc++) {
+            unsigned int& best = bestArc[graph.getTarget(arc)];
+            if(best == none || graph.getCost(arc) < graph.getCost(best)) {
+                best = arc;
+            }
+        }
+        for (size_t j = 0; j < n; j++) {
+            int const hop = next[i * n + j];
+            if(i != j && hop != -1) {
+                unsigned int const arc = bestArc[hop];
+                result.addEdge(graph.getId(i), graph.getId(hop), graph.getCost(arc), graph.isBidirectional(arc));
+            }
+        }
+        for (unsigned int arc = graph.arcsBegin(i); arc < graph.arcsEnd(i); arc++) {
+            bestArc[graph.getTarget(arc)] = none;
+        }
+    }
+    return result;
+}
+
+template <typename E>
+template <typename N>
+Graph<N,E> PathMatrix<E>::toGraph(Graph<N,E> const& graph) const {
+    return toGraph(graph.freeze());
+}
+
+template <typename E>
+Path<E>::Path(std::vector<int>&& nodes, std::vector<E>&& costs, std::vector<bool>&& bidirectional)
+    : nodes(std::move(nodes)), costs(std::move(costs)), bidirectional(std::move(bidirectional)) {
+    for (E const c : this->costs) {
+        cost += c;
+    }
+}
+
+template <typename E>
+int Path<E>::getNumNodes() const {
+    return nodes.size();
+}
+
+template <typename E>
+int Path<E>::getFrom() const {
+    return nodes.front();
+}
+
+template <typename E>
+int Path<E>::getTo() const {
+    return nodes.back();
+}
+
+//Returns the cost of the whole path
+template <typename E>
+E Path<E>::getCost() const {
+    return cost;
+}
+
+template <typename E>
+std::vector<int> const& Path<E>::getNodes() const {
+    return nodes;
+}
+
+template <typename E>
+std::vector<E> const& Path<E>::getCosts() const {
+    return costs;
+}
+
+template <typename E>
+bool Path<E>::isBidirectional(size_t const edge) const {
+    return bidirectional[edge];
+}
+
+//Builds the graph of the path, with the nodes of the graph it was found on
+template <typename E>
+template <typename N>
+Graph<N,E> Path<E>::toGraph(CsrGraph<N,E> const& graph) const {
+    Graph<N,E> path;
+    for (int const id : nodes) {
+        path.addNode(graph.makeNode(graph.getIndex(id)));
+    }
+    for (size_t i = 0; i < costs.size(); i++) {
+        path.addEdge(nodes[i], nodes[i + 1], costs[i], bidirectional[i]);
+    }
+    return path;
+}
+
+template <typename E>
+template <typename N>
+Graph<N,E> Path<E>::toGraph(Graph<N,E> const& graph) const {
+    Graph<N,E> path;
+    for (int const id : nodes) {
+        path.addNode(graph.getNode(id));
+    }
+    for (size_t i = 0; i < costs.size(); i++) {
+        path.addEdge(nodes[i], nodes[i + 1], costs[i], bidirectional[i]);
+    }
+    return path;
+}
+
+template <typename E>
+SpanningTree<E>::SpanningTree(std::vector<int>&& parents, std::vector<E>&& costs, std::vector<bool>&& bidirectional)
+    : parents(std::move(parents)), costs(std::move(costs)), bidirectional(std::move(bidirectional)) {
+    for (size_t i = 0; i < this->parents.size(); i++) {
+        if(this->parents[i] != -1) {
+            cost += this->costs[i];
+        }
+    }
+}
+
+template <typename E>
+int SpanningTree<E>::getNumNodes() const {
+    return parents.size();
+}
+
+template <typename E>
+int SpanningTree<E>::getParent(int const index) const {
+    return parents[index];
+}
+
+//Returns the cost of the edge joining the node to its parent
+template <typename E>
+E SpanningTree<E>::getEdgeCost(int const index) const {
+    return costs[index];
+}
+
+template <typename E>
+bool SpanningTree<E>::isBidirectional(int const index) const {
+    return bidirectional[index];
+}
+
+//Returns the cost of the whole tree
+template <typename E>
+E SpanningTree<E>::getCost() const {
+    return cost;
+}
+
+template <typename E>
+std::vector<int> const& SpanningTree<E>::getParents() const {
+    return parents;
+}
+
+//Builds the graph of the tree, with the nodes of the graph it spans
+template <typename E>
+template <typename N>
+Graph<N,E> SpanningTree<E>::toGraph(CsrGraph<N,E> const& graph) const {
+    Graph<N,E> tree;
+    for (size_t i = 0; i < parents.size(); i++) {
+        tree.addNode(graph.makeNode(i));
+    }
+    for (size_t i = 0; i < parents.size(); i++) {
+        if(parents[i] != -1) {
+            tree.addEdge(graph.getId(parents[i]), graph.getId(i), costs[i], bidirectional[i]);
+        }
+    }
+    return tree;
+}
+
+template <typename E>
+template <typename N>
+Graph<N,E> SpanningTree<E>::toGraph(Graph<N,E> const& graph) const {
+    Graph<N,E> tree;
+    for (size_t i = 0; i < parents.size(); i++) {
+        tree.addNode(graph.getNodes()[i]);
+    }
+    for (size_t i = 0; i < parents.size(); i++) {
+        if(parents[i] != -1) {
+            tree.addEdge(graph.getId(parents[i]), graph.getId(i), costs[i], bidirectional[i]);
+        }
+    }
+    return tree;
+}
+
+//Builds a tree where every node is settled
+template <typename E>
+ShortestPathTree<E>::ShortestPathTree(int const source, std::vector<E>&& distances, std::vector<int>&& predecessors, std::vector<unsigned int>&& arcs)
+    : source(source), distances(std::move(distances)), predecessors(std::move(predecessors)), arcs(std::move(arcs)), settled(this->distances.size(), true) {}
+
+//Builds a tree where only some nodes are settled, for searches stopping at some targets
+template <typename E>
+ShortestPathTree<E>::ShortestPathTree(int const source, std::vector<E>&& distances, std::vector<int>&& predecessors, std::vector<unsigned int>&& arcs,
+                                      std::vector<bool>&& settled)
+    : source(source), distances(std::move(distances)), predecessors(std::move(predecessors)), arcs(std::move(arcs)), settled(std::move(settled)) {}
+
+template <typename E>
+int ShortestPathTree<E>::getSource() const {
+    return source;
+}
+
+template <typename E>
+int ShortestPathTree<E>::getNumNodes() const {
+    return distances.size();
+}
+
+template <typename E>
+bool ShortestPathTree<E>::isReachable(int const index) const {
+    return index == source || predecessors[index] != -1;
+}
+
+//Returns whether the distance of the node is final: searches stopping at some targets leave some nodes unsettled
+template <typename E>
+bool ShortestPathTree<E>::isSettled(int const index) const {
+    return settled[index];
+}
+
+template <typename E>
+E ShortestPathTree<E>::getDistance(int const index) const {
+    return distances[index];
+}
+
+template <typename E>
+int ShortestPathTree<E>::getPredecessor(int const index) const {
+    return predecessors[index];
+}
+
+template <typename E>
+unsigned int ShortestPathTree<E>::getPredecessorArc(int const index) const {
+    return arcs[index];
+}
+
+//Returns the indices of the nodes on the path from the source, both ends included; empty if the node is not reachable
+template <typename E>
+std::vector<int> ShortestPathTree<E>::getPath(int const index) const {
+    std::vector<int> path;
+    if(!isReachable(index)) {
+        return path;
+    }
+    for (int current = index; current != -1; current = predecessors[current]) {
+        path.push_back(current);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+template <typename E>
+std::vector<E> const& ShortestPathTree<E>::getDistances() const {
+    return distances;
+}
+
+template <typename E>
+std::vector<int> const& ShortestPathTree<E>::getPredecessors() const {
+    return predecessors;
+}
+
+inline BreadthFirstTree::BreadthFirstTree(int const source, std::vector<int>&& levels, std::vector<int>&& parents)
+    : source(source), levels(std::move(levels)), parents(std::move(parents)) {
+    numReached = this->levels.size() - std::count(this->levels.begin(), this->levels.end(), -1);
+}
+
+inline int BreadthFirstTree::getSource() const {
+    return source;
+}
+
+inline int BreadthFirstTree::getNumNodes() const {
+    return levels.size();
+}
+
+//Returns how many nodes the search reached, the source included
+inline int BreadthFirstTree::getNumReached() const {
+    return numReached;
+}
+
+inline bool BreadthFirstTree::isReachable(int const index) const {
+    return levels[index] != -1;
+}
+
+inline int BreadthFirstTree::getLevel(int const index) const {
+    return levels[index];
+}
+
+inline int BreadthFirstTree::getParent(int const index) const {
+    return parents[index];
+}
+
+//Returns the indices of the nodes on the path from the source, both ends included; empty if the node is not reachable
+inline std::vector<int> BreadthFirstTree::getPath(int const index) const {
+    std::vector<int> path;
+    if(!isReachable(index)) {
+        return path;
+    }
+    for (int current = index; current != -1; current = parents[current]) {
+        path.push_back(current);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+inline std::vector<int> const& BreadthFirstTree::getLevels() const {
+    return levels;
+}
+
+inline std::vector<int> const& BreadthFirstTree::getParents() const {
+    return parents;
+}
+
+inline ComponentLabels::ComponentLabels(std::vector<int>&& labels, int const numComponents) : labels(std::move(labels)), sizes(numComponents, 0) {
+    for (int const label : this->labels) {
+        sizes[label]++;
+    }
+}
+
+inline int ComponentLabels::getNumNodes() const {
+    return labels.size();
+}
+
+inline int ComponentLabels::getNumComponents() const {
+    return sizes.size();
+}
+
+inline int ComponentLabels::getComponent(int const index) const {
+    return labels[index];
+}
+
+//Returns the number of nodes in the component
+inline int ComponentLabels::getSize(int const component) const {
+    return sizes[component];
+}
+
+inline std::vector<int> const& ComponentLabels::getLabels() const {
+    return labels;
+}
+
+//toLandmarks may be empty, if the distances to the landmarks are the same as the ones from them
+template <typename E>
+LandmarkTable<E>::LandmarkTable(std::vector<int> const& landmarks, std::vector<E>&& fromLandmarks, std::vector<E>&& toLandmarks)
+    : landmarks(landmarks), symmetric(toLandmarks.empty()), fromLandmarks(std::move(fromLandmarks)), toLandmarks(std::move(toLandmarks)) {}
+
+template <typename E>
+int LandmarkTable<E>::getNumLandmarks() const {
+    return landmarks.size();
+}
+
+template <typename E>
+std::vector<int> const& LandmarkTable<E>::getLandmarks() const {
+    return landmarks;
+}
+
+template <typename E>
+bool LandmarkTable<E>::isSymmetric() const {
+    return symmetric;
+}
+
+/* Returns a lower bound of the distance between two nodes (by index) from the triangle inequality:
+   d(v,t) >= d(L,t) - d(L,v) and d(v,t) >= d(v,L) - d(t,L) for every landmark L */
+template <typename E>
+E LandmarkTable<E>::lowerBound(int const fromIndex, int const toIndex) const {
+    E const max = std::numeric_limits<E>::max();
+    size_t const numLandmarks = landmarks.size();
+    std::vector<E> const& to = symmetric ? fromLandmarks : toLandmarks;
+    E const* const fromV = fromLandmarks.data() + fromIndex * numLandmarks;
+    E const* const fromT = fromLandmarks.data() + toIndex * numLandmarks;
+    E const* const toV = to.data() + fromIndex * numLandmarks;
+    E const* const toT = to.data() + toIndex * numLandmarks;
+    E bound = 0;
+    for (size_t l = 0; l < numLandmarks; l++) {
+        //Unreachable pairs give no usable bound
+        if(fromT[l] != max && fromV[l] != max) {
+            bound = std::max(bound, fromT[l] - fromV[l]);
+        }
+        if(toV[l] != max && toT[l] != max) {
+            bound = std::max(bound, toV[l] - toT[l]);
+        }
+    }
+    return bound;
+}
 
 #endif
\ No newline at end of file
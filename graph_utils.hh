@@ -2,6 +2,7 @@
 #define GRAPH_UTILS
 
 #include "graph_struct.hh"
+#include "graph_utils_parallel.hh"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -10,22 +11,34 @@
 #include <optional>
 #include <unordered_set>
 #include <vector>
+#include <string>
+#include <charconv>
+#include <mutex>
 
+//A malformed line found while loading a graph file; line 0 means the file itself could not be read
+struct ParseError {
+    size_t line;
+    std::string message;
+};
 
-template <typename N, typename E>
-static bool addNodes(Graph<N,E>& graph, int const dim, std::istream& file, int numNodes);
-template <typename N, typename E>
-static bool addEdges(Graph<N,E>& graph, std::istream& file, int numEdges);
+//Size of the pieces a graph file is split into for parsing
+constexpr size_t PARSE_CHUNK_SIZE = 1 << 20;
 
 namespace myGraphUtils
 {   
     template <typename N, typename E> 
     bool initGraph(std::string const filename, Graph<N,E>& graph);
     template <typename N, typename E>
+    std::vector<ParseError> parseGraph(std::string const filename, Graph<N,E>& graph, unsigned int numThreads = 0);
+    template <typename N, typename E>
     bool const isDirect(Graph<N,E> const& graph);
     template <typename N, typename E>
+    bool const isDirect(CsrGraph<N,E> const& graph);
+    template <typename N, typename E>
     bool const isConnected(Graph<N,E> const& graph);
     template <typename N, typename E>
+    bool const isConnected(CsrGraph<N,E> const& graph);
+    template <typename N, typename E>
     Graph<N,E> const makeDirect(Graph<N,E> const& graph);
     template <typename N, typename E>
     void drawGraph(Graph<N,E> const& graph);
@@ -45,70 +58,207 @@ void myGraphUtils::drawGraph(Graph<N,E> const& graph) {
 template <typename N, typename E>
 bool myGraphUtils::initGraph(std::string const filename, Graph<N,E>& graph)
 {
-    std::string line;
-    std::ifstream file(filename);
-    unsigned int dim, num_Edges, num_Nodes;
-    if (!file.is_open()) {
-        return false;
-    }
-    file >> dim >> num_Nodes >> num_Edges;
-    std::getline(file, line);
-    if(!addNodes(graph, dim, file, num_Nodes)) {
-        return false;
+    return parseGraph(filename, graph).empty();
+}
+
+//Skips blanks (not newlines), then reads one number that must end at a blank or at the end of the line
+template <typename T>
+static bool parseToken(char const*& p, char const* const end, T& value) {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
     }
-    if(!addEdges(graph, file, num_Edges)) {
+    auto const [next, ec] = std::from_chars(p, end, value);
+    if(ec != std::errc() || (next < end && *next != ' ' && *next != '\t' && *next != '\r')) {
         return false;
     }
+    p = next;
     return true;
 }
 
+inline bool isBlank(char const* p, char const* const end) {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p == end;
+}
+
+/* Loads a graph in the text format of graph_schema.txt. The file is read at once and split at line boundaries into
+   chunks, which are parsed on numThreads threads with std::from_chars; nodes and edges are then added in bulk.
+   Blank lines are skipped, any other line must hold exactly the expected fields
+    Parameters:
+        -filename:   the path of the file
+        -graph:      the graph the nodes and edges are added to, left unchanged if the file is malformed
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: the malformed lines (line number, starting from 1, and description) in file order, empty on success */
 template <typename N, typename E>
-static bool addNodes(Graph<N,E>& graph, int const dim, std::istream& file, int numNodes) {
-    std::string line, word;
-    while (numNodes-- > 0)
-    {
-        std::vector<float> coords;
-        int id;
-        N cost;
-        std::getline(file, line);
-        std::stringstream ss(line);
-        if(!(ss >> word)) {
-            return false;
+std::vector<ParseError> myGraphUtils::parseGraph(std::string const filename, Graph<N,E>& graph, unsigned int numThreads) {
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open()) {
+        return {{0, "can not open " + filename}};
+    }
+    //A directory opens, but the first read fails; then, as for streams which can not seek, tellg gives -1
+    file.peek();
+    file.seekg(0, std::ios::end);
+    std::streamoff const length = file.tellg();
+    if(length < 0) {
+        return {{0, "can not read " + filename}};
+    }
+    std::string text(length, '\0');
+    file.seekg(0);
+    if(!file.read(text.data(), text.size())) {
+        return {{0, "can not read " + filename}};
+    }
+    char const* const begin = text.data();
+    char const* const end = begin + text.size();
+    //Header: dimensions, number of nodes, number of edges
+    char const* const headerEnd = std::find(begin, end, '\n');
+    char const* p = begin;
+    unsigned int dim, numNodes, numEdges;
+    if(!parseToken(p, headerEnd, dim) || !parseToken(p, headerEnd, numNodes) || !parseToken(p, headerEnd, numEdges) || !isBlank(p, headerEnd)) {
+        return {{1, "expected <dimensions n_nodes n_edges>"}};
+    }
+    //Chunks of the body, each starting at the beginning of a line
+    if(numThreads == 0) {
+        numThreads = defaultNumThreads();
+    }
+    char const* const body = headerEnd < end ? headerEnd + 1 : end;
+    size_t const numChunks = std::max<size_t>(1, std::min<size_t>((end - body) / PARSE_CHUNK_SIZE, numThreads * 4));
+    std::vector<char const*> bounds(numChunks + 1, end);
+    bounds[0] = body;
+    for (size_t c = 1; c < numChunks; c++) {
+        char const* const split = std::max(bounds[c - 1], body + (end - body) / numChunks * c);
+        char const* const newline = std::find(split, end, '\n');
+        bounds[c] = newline < end ? newline + 1 : end;
+    }
+    //First pass: lines and records (non blank lines) per chunk, to number them
+    std::vector<size_t> firstLine(numChunks + 1, 0), firstRecord(numChunks + 1, 0);
+    auto forEachLine = [&](size_t const c, auto const& visit) {
+        for (char const* line = bounds[c]; line < bounds[c + 1];) {
+            char const* const lineEnd = std::find(line, bounds[c + 1], '\n');
+            visit(line, lineEnd);
+            line = lineEnd < bounds[c + 1] ? lineEnd + 1 : lineEnd;
         }
-        id = std::stoi(word);
-        for (size_t i = 0; i < dim; i++)
-        {
-            if(!(ss >> word)) {
-                return false;
+    };
+    parallelFor(0, numChunks, [&](size_t const c) {
+        forEachLine(c, [&](char const* const line, char const* const lineEnd) {
+            firstLine[c + 1]++;
+            firstRecord[c + 1] += !isBlank(line, lineEnd);
+        });
+    }, numThreads);
+    firstLine[0] = 2;
+    for (size_t c = 0; c < numChunks; c++) {
+        firstLine[c + 1] += firstLine[c];
+        firstRecord[c + 1] += firstRecord[c];
+    }
+    //Line of the given record, only needed to report errors
+    auto lineOf = [&](size_t const record) {
+        size_t const c = std::upper_bound(firstRecord.begin(), firstRecord.end(), record) - firstRecord.begin() - 1;
+        size_t lineNumber = firstLine[c], current = firstRecord[c], found = 0;
+        forEachLine(c, [&](char const* const line, char const* const lineEnd) {
+            if(!isBlank(line, lineEnd) && current++ == record) {
+                found = lineNumber;
             }
-            coords.push_back(std::stof(word));
+            lineNumber++;
+        });
+        return found;
+    };
+    //The header must match the body before anything is sized after it
+    size_t const numRecords = (size_t)numNodes + numEdges;
+    if(firstRecord[numChunks] < numRecords) {
+        return {{firstLine[numChunks] - 1, "missing lines: the header announces " + std::to_string(numNodes) +
+                                           " nodes and " + std::to_string(numEdges) + " edges"}};
+    }
+    if(firstRecord[numChunks] > numRecords) {
+        return {{lineOf(numRecords), "more lines than the " + std::to_string(numNodes) + " nodes and " +
+                                     std::to_string(numEdges) + " edges of the header"}};
+    }
+    //Second pass: the first numNodes records are nodes, the next numEdges ones edges
+    std::vector<Node<N,E>> nodes(numNodes);
+    std::vector<Edge<E>> edges(numEdges);
+    std::vector<std::vector<ParseError>> chunkErrors(numChunks);
+    parallelFor(0, numChunks, [&](size_t const c) {
+        size_t lineNumber = firstLine[c], record = firstRecord[c];
+        std::vector<float> coords(dim);
+        forEachLine(c, [&](char const* const line, char const* const lineEnd) {
+            size_t const current = lineNumber++;
+            if(isBlank(line, lineEnd)) {
+                return;
+            }
+            char const* p = line;
+            if(record < numNodes) {
+                int id;
+                N cost;
+                bool valid = parseToken(p, lineEnd, id);
+                for (unsigned int d = 0; valid && d < dim; d++) {
+                    valid = parseToken(p, lineEnd, coords[d]);
+                }
+                if(valid && parseToken(p, lineEnd, cost) && isBlank(p, lineEnd)) {
+                    nodes[record] = Node<N,E>(id, Coords(coords.data(), dim), cost);
+                } else {
+                    chunkErrors[c].push_back({current, "expected <id, " + std::to_string(dim) + " coords, cost>"});
+                }
+            } else {
+                int from, to, bidirectional;
+                E cost;
+                if(parseToken(p, lineEnd, from) && parseToken(p, lineEnd, to) && parseToken(p, lineEnd, cost) &&
+                   parseToken(p, lineEnd, bidirectional) && isBlank(p, lineEnd) && (bidirectional == 0 || bidirectional == 1)) {
+                    edges[record - numNodes] = Edge<E>(from, to, cost, bidirectional);
+                } else {
+                    chunkErrors[c].push_back({current, "expected <idfrom, idto, cost, bidirectional[1/0]>"});
+                }
+            }
+            record++;
+        });
+    }, numThreads);
+    std::vector<ParseError> errors;
+    for (std::vector<ParseError>& e : chunkErrors) {
+        errors.insert(errors.end(), e.begin(), e.end());
+    }
+    if(!errors.empty()) {
+        return errors;
+    }
+    //Node ids must be new, and edges must join known nodes
+    std::vector<std::pair<int, unsigned int>> ids(numNodes); //id, record
+    parallelForChunks(0, numNodes, [&](size_t const b, size_t const e) {
+        for (size_t i = b; i < e; i++) {
+            ids[i] = {nodes[i].getId(), i};
         }
-        if(!(ss >> cost)) {
-            return false;
+    }, numThreads);
+    parallelSort(ids, std::less<std::pair<int, unsigned int>>(), numThreads);
+    auto known = [&](int const id) {
+        auto const it = std::lower_bound(ids.begin(), ids.end(), std::make_pair(id, 0u));
+        return (it != ids.end() && it->first == id) || graph.hasNode(id);
+    };
+    for (size_t i = 0; i < ids.size(); i++) {
+        if((i > 0 && ids[i].first == ids[i - 1].first) || graph.hasNode(ids[i].first)) {
+            errors.push_back({lineOf(ids[i].second), "duplicate node id " + std::to_string(ids[i].first)});
         }
-        if(!graph.addNode(Node<N,E>(id, coords, cost))) {
-            return false;
+    }
+    std::vector<size_t> unknown; //edges joining an unknown node, rare enough to share one list
+    std::mutex unknownMutex;
+    parallelForChunks(0, numEdges, [&](size_t const b, size_t const e) {
+        for (size_t i = b; i < e; i++) {
+            if(!known(edges[i].getFrom()) || !known(edges[i].getTo())) {
+                std::lock_guard<std::mutex> lock(unknownMutex);
+                unknown.push_back(i);
+            }
         }
+    }, numThreads);
+    for (size_t const i : unknown) {
+        errors.push_back({lineOf(numNodes + i), "unknown node id in edge " + std::to_string(edges[i].getFrom()) +
+                                                " -> " + std::to_string(edges[i].getTo())});
     }
-    return true;
-}
-
-template <typename N, typename E>
-static bool addEdges(Graph<N,E>& graph, std::istream& file, int numEdges) {
-    std::string line;
-    while (numEdges-- > 0)
-    {
-        //std::unordered_set<Node> nodes = graph.getNodes();
-        int fromid, toid;
-        E cost;
-        bool bidirectional;
-        file >> fromid >> toid >> cost >> bidirectional;
-        graph.addEdge(fromid, toid, cost, bidirectional);
-        std::getline(file, line);
+    if(!errors.empty()) {
+        std::sort(errors.begin(), errors.end(), [](ParseError const& a, ParseError const& b) { return a.line < b.line; });
+        return errors;
     }
-    return true;
+    graph.addNodes(std::move(nodes));
+    graph.addEdges(edges);
+    return {};
 }
 
+/* Returns a copy of the graph where every bidirectional edge is also stored reversed, at its end node.
+   To walk the edges leaving a node that way without copying the graph, use Graph::getAdjacency */
 template <typename N, typename E>
 Graph<N,E> const myGraphUtils::makeDirect(Graph<N,E> const& graph) {
     Graph<N,E> copy(graph);
@@ -121,80 +271,109 @@ Graph<N,E> const myGraphUtils::makeDirect(Graph<N,E> const& graph) {
 }
 
 
+/* Tells whether every node can be reached from the first one. Without one-way edges this is the component count
+   the graph keeps up to date, so it takes O(1); otherwise a graph with more than one weak component is not connected
+   either, and only a single weak component needs a search, which walks the adjacency views instead of a copy */
 template <typename N, typename E>
 bool const myGraphUtils::isConnected(Graph<N,E> const& graph) {
+    if(graph.getNumComponents() > 1) {
+        return false;
+    }
+    if(graph.getNumDirectedEdges() == 0) {
+        return true;
+    }
     int const target = graph.getNumNodes();
-    Graph<N,E> copy;
-    copy = graph;
-    myGraphUtils::makeDirect(copy);
-    std::unordered_map<int, bool> flag; //Given node id, it tells whether the node is part (connected) of the graph
-    std::queue<Node<N,E>> nodes;
-    Node<N,E> current = (*copy.getNodes().begin());
-    for (auto const& n : copy.getNodes())
-    {
-        flag[n.getId()] = false;
-    }
-    flag[current.getId()] = true;
-    nodes.push(current);
-    int k = 1; //Number of nodes visited
-    while(!nodes.empty() && k < target) {
-        current = nodes.front();
-        nodes.pop();
-        
-        for (Edge<E> const& e : current.getAdjacentEdges())
-        {
-            Node<N,E> const& n = graph.getNode(e.getTo());
-            if(!flag[n.getId()]) {
-                nodes.push(n);
-                flag[n.getId()] = true;
-                k++;
+    ScratchVector<bool> flag(target, false, myGraphUtils::getScratchResource());
+    ScratchVector<int> nodes(myGraphUtils::getScratchResource()); //BFS queue, holding node indices
+    nodes.reserve(target);
+    nodes.push_back(0);
+    flag[0] = true;
+    for (size_t head = 0; head < nodes.size() && (int)nodes.size() < target; head++) {
+        AdjacencyView<N,E> const adjacency = graph.getAdjacency(graph.getId(nodes[head]));
+        for (size_t i = 0; i < adjacency.size(); i++) {
+            int const n = adjacency.getTargetIndex(i);
+            if(!flag[n]) {
+                flag[n] = true;
+                nodes.push_back(n);
             }
         }
     }
-    return k == target;
+    return (int)nodes.size() == target;
 }
 
 template <typename N, typename E>
-bool const myGraphUtils::isDirect(Graph<N,E> const& graph) {
-    for (Edge<E> const e : graph.getEdges())
-    {
-        if(!e.isBidirectional()) {
-            return true;
+bool const myGraphUtils::isConnected(CsrGraph<N,E> const& graph) {
+    int const target = graph.getNumNodes();
+    if(target <= 1) {
+        return true;
+    }
+    if(graph.getNumComponents() > 1) {
+        return false;
+    }
+    if(graph.getNumDirectedEdges() == 0) {
+        return true;
+    }
+    ScratchVector<bool> flag(target, false, myGraphUtils::getScratchResource()); //Given a node index, it tells whether the node is part (connected) of the graph
+    ScratchVector<int> nodes(myGraphUtils::getScratchResource()); //BFS queue, holding node indices
+    nodes.reserve(target);
+    nodes.push_back(0);
+    flag[0] = true;
+    for (size_t head = 0; head < nodes.size() && (int)nodes.size() < target; head++) {
+        int const current = nodes[head];
+        for (unsigned int arc = graph.arcsBegin(current); arc < graph.arcsEnd(current); arc++)
+        {
+            int const n = graph.getTarget(arc);
+            if(!flag[n]) {
+                flag[n] = true;
+                nodes.push_back(n);
+            }
         }
     }
-    return false;
+    return (int)nodes.size() == target;
+}
+
+//Tells whether the graph has one-way edges, in O(1): the graph counts them as they are added
+template <typename N, typename E>
+bool const myGraphUtils::isDirect(Graph<N,E> const& graph) {
+    return graph.getNumDirectedEdges() > 0;
+}
+
+template <typename N, typename E>
+bool const myGraphUtils::isDirect(CsrGraph<N,E> const& graph) {
+    return graph.getNumDirectedEdges() > 0;
 }
 
 template <typename N, typename E>
 Graph<N,E> const myGraphUtils::stripRedundantEdges(Graph<N,E> const& graph, bool const takeMin) {
     Graph<N,E> strippedGraph;
     for (Node<N,E> const& node : graph.getNodes()) {
-        strippedGraph.addNode(node);
+        //Only the node data is copied, the adjacency is rebuilt by addEdge
+        strippedGraph.addNode(Node<N,E>(node.getId(), node.getCoords(), node.getCost()));
     }
+    //Given a target node index, the position of the best edge reaching it in "best" (-1 if none yet),
+    //reset after each node by walking "best" itself
+    std::vector<int> bestPos(graph.getNodes().size(), -1);
+    std::vector<Edge<E>> best;
     for (Node<N,E> const& node : graph.getNodes())
     {
-        std::unordered_map<int, Edge<E>> best;
-        for (Edge<E> edge : node.getAdjacentEdges())
+        AdjacencyView<N,E> const adjacency = graph.getAdjacency(node.getId());
+        for (size_t i = 0; i < adjacency.getNumStored(); i++)
         {
-            auto previous = best.find(edge.getTo());
-            if(previous == best.end()) {
-                best.insert_or_assign(edge.getTo(), edge);
-            } else {
-                Edge<E> bestEdge;
-                if(takeMin) {
-                    bestEdge = (*previous).second < edge ? (*previous).second : edge;
-                } else {
-                    bestEdge = (*previous).second > edge ? (*previous).second : edge;
-                }
-                best.insert_or_assign(bestEdge.getTo(), bestEdge);
+            Edge<E> const edge = adjacency[i];
+            int& previous = bestPos[graph.getIndex(edge.getTo())];
+            if(previous == -1) {
+                previous = best.size();
+                best.push_back(edge);
+            } else if(takeMin ? edge < best[previous] : best[previous] < edge) {
+                best[previous] = edge;
             }
         }
-        for (auto const& pair : best)
+        for (Edge<E> const& e : best)
         {
-            Edge<E> e = pair.second;
-
             strippedGraph.addEdge(e.getFrom(), e.getTo(), e.getCost(), e.isBidirectional());
+            bestPos[graph.getIndex(e.getTo())] = -1;
         }
+        best.clear();
     }
     return strippedGraph;
 }
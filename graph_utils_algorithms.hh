@@ -3,141 +3,434 @@
 
 #include "graph_utils.hh"
 #include "graph_struct.hh"
+#include "graph_utils_parallel.hh"
+#include "graph_utils_heap.hh"
 #include <optional>
-#include <map>
 #include <algorithm>
 #include <limits>
 #include <unordered_map>
 #include <queue>
 #include <utility>
+#include <vector>
+#include <type_traits>
+#include <atomic>
+#include <stdexcept>
+#include <cmath>
 
 #pragma region SST
 
+/* How compute_SST_Kruskal picks its edges:
+    -KRUSKAL_SORT:   sorts all the edges up front
+    -KRUSKAL_FILTER: Filter-Kruskal, partitions the edges around a pivot cost and drops the heavier ones whose
+                     ends are already connected before sorting them, which pays off on dense graphs
+    -KRUSKAL_AUTO:   filters when the graph has more than KRUSKAL_FILTER_DENSITY edges per node */
+enum KruskalMode {KRUSKAL_AUTO, KRUSKAL_SORT, KRUSKAL_FILTER};
+constexpr int KRUSKAL_FILTER_DENSITY = 8;
+
+//An edge of the graph as seen by Kruskal's algorithm, with the node indices of its ends
+template <typename E>
+struct KruskalEdge {
+    E cost;
+    int from, to;
+};
+
+/* Sorts edges by cost: radix sort for integral costs, merge of sorted chunks otherwise, both in parallel */
+template <typename E>
+static void sortKruskalEdges(ScratchVector<KruskalEdge<E>>& edges, unsigned int const numThreads) {
+    if constexpr (std::is_integral_v<E>) {
+        myGraphUtils::parallelRadixSort(edges, [](KruskalEdge<E> const& e) { return e.cost; }, numThreads);
+    } else {
+        myGraphUtils::parallelSort(edges, [](KruskalEdge<E> const& a, KruskalEdge<E> const& b) { return a.cost < b.cost; }, numThreads);
+    }
+}
+
+/* Adds to the tree the edges in [begin, end) that join two different components, in order of cost.
+   Returns false once the tree is complete */
+template <typename E>
+static bool addKruskalEdges(typename ScratchVector<KruskalEdge<E>>::iterator const begin,
+                            typename ScratchVector<KruskalEdge<E>>::iterator const end, DisjointSet& components,
+                            ScratchVector<KruskalEdge<E>>& tree, unsigned int const numThreads) {
+    ScratchVector<KruskalEdge<E>> edges(begin, end, myGraphUtils::getScratchResource());
+    sortKruskalEdges(edges, numThreads);
+    GRAPH_STATS_ADD(RELAXATIONS, edges.size());
+    for (KruskalEdge<E> const& e : edges)
+    {
+        // If the nodes at the two extremes of the edge are from a different sub-graph, we add the the edge to the SST
+        if(components.unite(e.from, e.to)) {
+            tree.push_back(e);
+            if(components.getNumSets() == 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Filter-Kruskal: the edges lighter than a pivot are handled first, recursively, then the heavier ones
+   that still join two components. Small ranges are simply sorted */
+template <typename E>
+static bool filterKruskal(int const numNodes, typename ScratchVector<KruskalEdge<E>>::iterator const begin,
+                          typename ScratchVector<KruskalEdge<E>>::iterator end, DisjointSet& components,
+                          ScratchVector<KruskalEdge<E>>& tree, unsigned int const numThreads) {
+    size_t const size = end - begin;
+    if(size <= std::max<size_t>(numNodes, 1024)) {
+        return addKruskalEdges(begin, end, components, tree, numThreads);
+    }
+    //The pivot is the median cost of an evenly spaced sample
+    ScratchVector<E> sample(myGraphUtils::getScratchResource());
+    for (size_t i = 0; i < size; i += size / 31) {
+        sample.push_back(begin[i].cost);
+    }
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+    E const pivot = sample[sample.size() / 2];
+    auto middle = std::partition(begin, end, [pivot](KruskalEdge<E> const& e) { return e.cost <= pivot; });
+    if(middle == end) {
+        //All the costs are at most the pivot: partitioning again would not shrink the range
+        return addKruskalEdges(begin, end, components, tree, numThreads);
+    }
+    if(!filterKruskal(numNodes, begin, middle, components, tree, numThreads)) {
+        return false;
+    }
+    end = std::remove_if(middle, end, [&components](KruskalEdge<E> const& e) { return components.connected(e.from, e.to); });
+    return filterKruskal(numNodes, middle, end, components, tree, numThreads);
+}
+
+/* Builds the parent array of the tree made of the given (bidirectional) edges, rooted at the node with index 0 */
+template <typename E>
+static SpanningTree<E> rootSpanningTree(int const numNodes, ScratchVector<KruskalEdge<E>> const& edges) {
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    //The edges touching every node, by counting sort of their ends
+    ScratchVector<unsigned int> offsets(numNodes + 1, 0, scratch), incident(2 * edges.size(), scratch);
+    for (KruskalEdge<E> const& e : edges) {
+        offsets[e.from + 1]++;
+        offsets[e.to + 1]++;
+    }
+    for (int i = 0; i < numNodes; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    ScratchVector<unsigned int> next(offsets.begin(), offsets.end() - 1, scratch);
+    for (size_t e = 0; e < edges.size(); e++) {
+        incident[next[edges[e].from]++] = e;
+        incident[next[edges[e].to]++] = e;
+    }
+    std::vector<int> parents(numNodes, -1);
+    std::vector<E> costs(numNodes, E(0));
+    std::vector<bool> visited(numNodes, false);
+    ScratchVector<int> nodes(scratch); //BFS queue, holding node indices
+    nodes.reserve(numNodes);
+    if(numNodes > 0) {
+        nodes.push_back(0);
+        visited[0] = true;
+    }
+    for (size_t head = 0; head < nodes.size(); head++) {
+        int const current = nodes[head];
+        for (unsigned int i = offsets[current]; i < offsets[current + 1]; i++) {
+            KruskalEdge<E> const& e = edges[incident[i]];
+            int const other = e.from == current ? e.to : e.from;
+            if(!visited[other]) {
+                visited[other] = true;
+                parents[other] = current;
+                costs[other] = e.cost;
+                nodes.push_back(other);
+            }
+        }
+    }
+    //Every edge of a tree found on an undirected graph is bidirectional
+    return SpanningTree<E>(std::move(parents), std::move(costs), std::vector<bool>(numNodes, true));
+}
+
 /* Computes the shortest spanning tree using Kruskal's algorithm 
     Parameters:
-        -graph: a reference to the original graph
-    Returns: an optional containing the sst graph if the operation was succesful, otherwise an empty one */
+        -graph:      a reference to the original graph
+        -mode:       how the edges are sorted, see KruskalMode
+        -numThreads: the number of threads used to sort the edges, 0 means one per hardware thread
+    Returns: an optional containing the sst if the operation was succesful, otherwise an empty one */
+template <typename N, typename E>
+std::optional<SpanningTree<E>> compute_SST_Kruskal(Graph<N,E> const& graph, KruskalMode const mode = KRUSKAL_AUTO, unsigned int const numThreads = 0)
+{
+    return compute_SST_Kruskal(graph.freeze(), mode, numThreads);
+}
+
+/* Computes the shortest spanning tree using Kruskal's algorithm on a CSR snapshot of the graph, merging the
+   sub-trees with a disjoint-set forest
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -mode:       how the edges are sorted, see KruskalMode
+        -numThreads: the number of threads used to sort the edges, 0 means one per hardware thread
+    Returns: an optional containing the sst (see SpanningTree::toGraph) if the operation was succesful, otherwise an empty one */
 template <typename N, typename E>
-std::optional<Graph<N,E>> compute_SST_Kruskal(Graph<N,E> const& graph)
+std::optional<SpanningTree<E>> compute_SST_Kruskal(CsrGraph<N,E> const& graph, KruskalMode const mode = KRUSKAL_AUTO, unsigned int const numThreads = 0)
 {
+    GRAPH_STATS_SCOPE("compute_SST_Kruskal");
     if(myGraphUtils::isDirect(graph) && graph.getNumNodes() > 0) {
         return {};
     }
-    // We don't need the make the tree direct since the algorithm does not need to navigate the graph
-    int const numNodes = graph.getNumNodes(), numEdges = graph.getNumEdges();
-    int k = 0;
-    Graph<N,E> copy;
-    copy = graph;
-    Graph<N,E> sst;
-    // The map that stores under which sub-graph a node resides
-    std::unordered_map<int, int> nodeTags;
-    std::vector<Edge<E>> orderedEdges = copy.getEdges();
-    std::sort(orderedEdges.begin(), orderedEdges.end());
-    //Initialing nodeTags: each node is assigned to a different sub-graph
-    for (Node<N,E> const& n : copy.getNodes())
+    //No spanning tree can join several components
+    if(graph.getNumComponents() > 1) {
+        return {};
+    }
+    int const numNodes = graph.getNumNodes();
+    ScratchVector<KruskalEdge<E>> tree(myGraphUtils::getScratchResource());
+    if(numNodes <= 1) {
+        return rootSpanningTree(numNodes, tree);
+    }
+    tree.reserve(numNodes - 1);
+    // Each node starts in its own sub-graph
+    DisjointSet components(numNodes);
+    // One entry for each edge: the reversed copies of the bidirectional edges are skipped
+    GRAPH_STATS_PHASE("collect");
+    ScratchVector<KruskalEdge<E>> edges(myGraphUtils::getScratchResource());
+    edges.reserve(graph.getNumEdges());
+    for (int i = 0; i < numNodes; i++)
     {
-        nodeTags[n.getId()] = n.getId();
+        for (unsigned int arc = graph.arcsBegin(i); arc < graph.arcsEnd(i); arc++) {
+            if(!graph.isReversed(arc) && graph.getTarget(arc) != i) {
+                edges.push_back({graph.getCost(arc), i, graph.getTarget(arc)});
+            }
+        }
     }
-    
-    for (Edge<E> const& e : orderedEdges)
+    GRAPH_STATS_PHASE("sort and merge");
+    bool const filter = mode == KRUSKAL_FILTER || (mode == KRUSKAL_AUTO && edges.size() > (size_t)KRUSKAL_FILTER_DENSITY * numNodes);
+    if(filter) {
+        filterKruskal(numNodes, edges.begin(), edges.end(), components, tree, numThreads);
+    } else {
+        addKruskalEdges(edges.begin(), edges.end(), components, tree, numThreads);
+    }
+    // If the sst does not connect all the nodes, the algorithm has failed to find the SST
+    if(components.getNumSets() > 1) {
+        return {};
+    }
+    GRAPH_STATS_PHASE("tree");
+    return rootSpanningTree(numNodes, tree);
+}
+
+/* Computes the shortest spanning tree using Boruvka's algorithm 
+    Parameters:
+        -graph:      a reference to the original graph
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: an optional containing the sst if the operation was succesful, otherwise an empty one */
+template <typename N, typename E>
+std::optional<SpanningTree<E>> compute_SST_Boruvka(Graph<N,E> const& graph, unsigned int const numThreads = 0)
+{
+    return compute_SST_Boruvka(graph.freeze(), numThreads);
+}
+
+/* Computes the shortest spanning tree using Boruvka's algorithm on a CSR snapshot of the graph.
+   Each round finds, in parallel over the edges, the cheapest edge leaving every component, adds them all to the tree
+   and contracts the components they join by pointer jumping; edges inside a component are then dropped.
+   Ties are broken by edge position, so the cheapest edges never form a cycle and the tree is the one Kruskal finds
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: an optional containing the sst (see SpanningTree::toGraph) if the operation was succesful, otherwise an empty one */
+template <typename N, typename E>
+std::optional<SpanningTree<E>> compute_SST_Boruvka(CsrGraph<N,E> const& graph, unsigned int const numThreads = 0)
+{
+    GRAPH_STATS_SCOPE("compute_SST_Boruvka");
+    if(myGraphUtils::isDirect(graph) && graph.getNumNodes() > 0) {
+        return {};
+    }
+    //No spanning tree can join several components
+    if(graph.getNumComponents() > 1) {
+        return {};
+    }
+    int const numNodes = graph.getNumNodes();
+    unsigned int const none = std::numeric_limits<unsigned int>().max();
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<KruskalEdge<E>> tree(scratch);
+    if(numNodes <= 1) {
+        return rootSpanningTree(numNodes, tree);
+    }
+    // The original edges (one entry for each bidirectional pair of arcs), and the ones still between two components,
+    // whose ends are relabelled to the representative of their component after each round
+    GRAPH_STATS_PHASE("collect");
+    ScratchVector<KruskalEdge<E>> original(scratch);
+    original.reserve(graph.getNumEdges());
+    for (int i = 0; i < numNodes; i++)
     {
-        Node<N,E> & from = copy.getNode(e.getFrom());
-        Node<N,E> & to = copy.getNode(e.getTo());
-        int fromTag = nodeTags[from.getId()];
-        int toTag = nodeTags[to.getId()];
-        // If the nodes at the two extremes of the edge are from a different sub-graph, we add the the edge
-        // and the nodes to the SST
-        if (fromTag != toTag) {
-            k++;
-            sst.addNode(from);
-            sst.addNode(to);
-            sst.addEdge(fromTag, toTag, e.getCost(), e.isBidirectional());
-            // Change the tag of every node which was part of the sub-graph with the tag "toTag"
-            for (std::pair<int,int> tag : nodeTags) {
-                if (tag.second == toTag) {
-                    nodeTags[tag.first] = fromTag;
+        for (unsigned int arc = graph.arcsBegin(i); arc < graph.arcsEnd(i); arc++) {
+            if(!graph.isReversed(arc) && graph.getTarget(arc) != i) {
+                original.push_back({graph.getCost(arc), i, graph.getTarget(arc)});
+            }
+        }
+    }
+    ScratchVector<unsigned int> remaining(original.size(), scratch);
+    ScratchVector<std::pair<int,int>> ends(original.size(), scratch);
+    for (size_t e = 0; e < original.size(); e++) {
+        remaining[e] = e;
+        ends[e] = {original[e].from, original[e].to};
+    }
+    auto lighter = [&original](unsigned int const a, unsigned int const b) {
+        return original[a].cost < original[b].cost || (!(original[b].cost < original[a].cost) && a < b);
+    };
+    ScratchVector<int> active(numNodes, scratch); // The representatives of the current components
+    for (int i = 0; i < numNodes; i++) {
+        active[i] = i;
+    }
+    ScratchVector<std::atomic<unsigned int>> best(numNodes, scratch); // Given a representative, the cheapest edge leaving its component
+    ScratchVector<int> parent(numNodes, scratch), jumped(numNodes, scratch);
+    ScratchVector<unsigned int> chosen(scratch);
+    GRAPH_STATS_PHASE("rounds");
+    while(active.size() > 1 && !remaining.empty()) {
+        GRAPH_STATS_ADD(RELAXATIONS, remaining.size());
+        myGraphUtils::parallelForChunks(0, active.size(), [&](size_t const begin, size_t const end) {
+            for (size_t c = begin; c < end; c++) {
+                best[active[c]].store(none, std::memory_order_relaxed);
+            }
+        }, numThreads);
+        myGraphUtils::parallelForChunks(0, remaining.size(), [&](size_t const begin, size_t const end) {
+            for (size_t r = begin; r < end; r++) {
+                unsigned int const e = remaining[r];
+                for (int const component : {ends[e].first, ends[e].second}) {
+                    unsigned int current = best[component].load(std::memory_order_relaxed);
+                    while((current == none || lighter(e, current)) &&
+                          !best[component].compare_exchange_weak(current, e, std::memory_order_relaxed));
                 }
             }
-            // Exit if the sst contains numNodes - 1 nodes
-            if (k >= numNodes - 1) {
-                break;
+        }, numThreads);
+        // Every component points to the one across its cheapest edge; in a pair pointing at each other
+        // the smaller one becomes the root, the other one brings the (shared) edge into the tree
+        myGraphUtils::parallelForChunks(0, active.size(), [&](size_t const begin, size_t const end) {
+            for (size_t c = begin; c < end; c++) {
+                int const component = active[c];
+                unsigned int const e = best[component].load(std::memory_order_relaxed);
+                parent[component] = e == none ? component : (ends[e].first == component ? ends[e].second : ends[e].first);
+            }
+        }, numThreads);
+        myGraphUtils::parallelForChunks(0, active.size(), [&](size_t const begin, size_t const end) {
+            for (size_t c = begin; c < end; c++) {
+                int const component = active[c];
+                int const other = parent[component];
+                jumped[component] = parent[other] == component && component < other ? component : other;
             }
+        }, numThreads);
+        parent.swap(jumped);
+        for (int const component : active) {
+            if(parent[component] != component) {
+                chosen.push_back(best[component].load(std::memory_order_relaxed));
+            }
+        }
+        // Pointer jumping until every component points to its root
+        std::atomic<bool> changed = true;
+        while(changed) {
+            changed = false;
+            myGraphUtils::parallelForChunks(0, active.size(), [&](size_t const begin, size_t const end) {
+                bool localChange = false;
+                for (size_t c = begin; c < end; c++) {
+                    int const component = active[c];
+                    jumped[component] = parent[parent[component]];
+                    localChange = localChange || jumped[component] != parent[component];
+                }
+                if(localChange) {
+                    changed = true;
+                }
+            }, numThreads);
+            parent.swap(jumped);
         }
+        active.erase(std::remove_if(active.begin(), active.end(), [&parent](int const c) { return parent[c] != c; }), active.end());
+        // Relabelling the ends of the remaining edges and dropping the ones inside a component
+        myGraphUtils::parallelForChunks(0, remaining.size(), [&](size_t const begin, size_t const end) {
+            for (size_t r = begin; r < end; r++) {
+                std::pair<int,int>& edgeEnds = ends[remaining[r]];
+                edgeEnds = {parent[edgeEnds.first], parent[edgeEnds.second]};
+            }
+        }, numThreads);
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&ends](unsigned int const e) {
+            return ends[e].first == ends[e].second;
+        }), remaining.end());
     }
-    // If the sst does not have numNodes - 1 nodes, the algorithm has failes to find the SST
-    if(k < numNodes - 1) {
+    // If the sst does not connect all the nodes, the algorithm has failed to find the SST
+    if(active.size() > 1) {
         return {};
     }
-    return {sst};
+    GRAPH_STATS_PHASE("tree");
+    std::sort(chosen.begin(), chosen.end());
+    tree.reserve(chosen.size());
+    for (unsigned int const e : chosen) {
+        tree.push_back(original[e]);
+    }
+    return rootSpanningTree(numNodes, tree);
 }
 
-#include <iostream>
-
 /* Computes the shortest spanning tree using Prim's algorithm 
     Parameters:
         -graph: a reference to the original graph
-    Returns: an optional containing the sst graph if the operation was succesful, otherwise an empty one */
+    Returns: an optional containing the sst if the operation was succesful, otherwise an empty one */
 template <typename N, typename E>
-std::optional<Graph<N,E>> compute_SST_Prim(Graph<N,E> const& graph) {
-    //Pred map is not needed in this implementation since we have defined edges as objects, with both ends stored in them as a reference
+std::optional<SpanningTree<E>> compute_SST_Prim(Graph<N,E> const& graph) {
+    return compute_SST_Prim(graph.freeze());
+}
 
+/* Computes the shortest spanning tree using Prim's algorithm on a CSR snapshot of the graph
+    Parameters:
+        -graph: a reference to the frozen graph
+    Returns: an optional containing the sst (see SpanningTree::toGraph) if the operation was succesful, otherwise an empty one */
+template <typename N, typename E>
+std::optional<SpanningTree<E>> compute_SST_Prim(CsrGraph<N,E> const& graph) {
+    GRAPH_STATS_SCOPE("compute_SST_Prim");
     //Check that the graph is direct
     if(myGraphUtils::isDirect(graph) && graph.getNumNodes() > 0 && !myGraphUtils::isConnected(graph)) {
         return {};
     }
-    //A copy of the graph which will be turned to direct to make navigation easier and the code cleaner
-    Graph<N,E> const& directg = myGraphUtils::makeDirect(graph);
-
-    std::unordered_map<int, bool> flag; //Given a node id, tells if the node is part of the mst (true) or not (false)
-    std::unordered_map<int, E> min; //Given a node id, tells the cost of the edge currently in use to reach it
-    Graph<N,E> sst;
-    Node<N,E> current = (*directg.getNodes().begin());
-    std::priority_queue<Edge<E>, std::vector<Edge<E>>, std::greater<Edge<E>>> cutEdges;
-    //Setting the initial state
-    for (Edge<E> const& e : directg.getEdges())
-    {
-        //All nodes are labeled as not visited, their "min" value is initialized
-        //to max if they are not connected to the starting node
-        flag.insert({e.getFrom(), false});
-        flag.insert({e.getTo(), false});
-        min.insert({e.getTo(), std::numeric_limits<E>().max()});
-    }
-
-    for (Edge<E> const& e : current.getAdjacentEdges()) {
-        if(e.getCost() < min.at(e.getTo())) {
-            min.insert_or_assign(e.getTo(), e.getCost());
-            cutEdges.push(e);
-        }
+    int const numNodes = graph.getNumNodes();
+    //The tree, node 0 being its root
+    std::vector<int> parents(numNodes, -1);
+    std::vector<E> costs(numNodes, E(0));
+    std::vector<bool> bidirectional(numNodes, true);
+    if(numNodes == 0) {
+        return SpanningTree<E>();
     }
-    sst.addNode(current);
-    flag.insert_or_assign(current.getId(), true);
-    min.insert_or_assign(current.getId(), 0);
+    //The snapshot is already direct, so we can navigate it without making a copy
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<bool> flag(numNodes, false, scratch); //Given a node index, tells if the node is part of the mst (true) or not (false)
+    ScratchVector<E> min(numNodes, std::numeric_limits<E>().max(), scratch); //Given a node index, tells the cost of the edge currently in use to reach it
+    ScratchVector<unsigned int> bestArc(numNodes, scratch); //Given a node index, tells the arc currently in use to reach it
+    //(cost, node index) pairs; an entry is stale if its node has already been added to the mst
+    std::priority_queue<std::pair<E,int>, ScratchVector<std::pair<E,int>>, std::greater<std::pair<E,int>>> cutEdges{
+        std::greater<std::pair<E,int>>(), ScratchVector<std::pair<E,int>>(scratch)};
+    int current = 0;
     
-    const int targetNumNodes = directg.getNumNodes() - 1;
-    int k;
-    for (k = 0; k < targetNumNodes && !cutEdges.empty(); k++) {
-        Edge<E> bestEdge;
-        do {
-             bestEdge = cutEdges.top();
-             cutEdges.pop();
-        } while (flag.at(bestEdge.getTo()));
-        current = directg.getNode(bestEdge.getTo());
-        //Adding the target node to the the MST
-        flag.insert_or_assign(current.getId(), true);
-        sst.addNode(current);
-        sst.addEdge(bestEdge.getFrom(), bestEdge.getTo(), bestEdge.getCost(), bestEdge.isBidirectional());
+    const int targetNumNodes = numNodes - 1;
+    int k = 0;
+    while (true) {
+        //Adding the current node to the the MST
+        flag[current] = true;
+        GRAPH_STATS_ADD(SETTLED, 1);
+        if(current != 0) {
+            costs[current] = min[current];
+            bidirectional[current] = graph.isBidirectional(bestArc[current]);
+            k++;
+        }
+        if(k == targetNumNodes) {
+            break;
+        }
         //Updating the edges with new information from the newly added node
-        for (Edge<E> const& e : current.getAdjacentEdges())
+        GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(current) - graph.arcsBegin(current));
+        for (unsigned int arc = graph.arcsBegin(current); arc < graph.arcsEnd(current); arc++)
         {
-            Node<N,E> const& target = directg.getNode(e.getTo());
-            if(!flag.at(target.getId()) && min.at(target.getId()) > e.getCost()) {
-                min.insert_or_assign(target.getId(), e.getCost());
-                cutEdges.push(e);
+            int const target = graph.getTarget(arc);
+            if(!flag[target] && min[target] > graph.getCost(arc)) {
+                min[target] = graph.getCost(arc);
+                bestArc[target] = arc;
+                parents[target] = current;
+                cutEdges.push({min[target], target});
+                GRAPH_STATS_ADD(HEAP_PUSHES, 1);
             }
         }
+        while (!cutEdges.empty() && flag[cutEdges.top().second]) {
+            cutEdges.pop();
+            GRAPH_STATS_ADD(HEAP_POPS, 1);
+            GRAPH_STATS_ADD(STALE_POPS, 1);
+        }
+        if(cutEdges.empty()) {
+            break;
+        }
+        current = cutEdges.top().second;
+        cutEdges.pop();
+        GRAPH_STATS_ADD(HEAP_POPS, 1);
     }
     if( k == targetNumNodes) {
-        return sst;
+        return SpanningTree<E>(std::move(parents), std::move(costs), std::move(bidirectional));
     }
     return {};
 }
@@ -151,114 +444,1889 @@ std::optional<Graph<N,E>> compute_SST_Prim(Graph<N,E> const& graph) {
         -graph:  a reference to the original graph
         -fromId: the id of the starting node
         -toId:   the id of the end node
-    Returns: an optional containing the shortest path if the operation was succesful, otherwise an empty graph*/
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
 template <typename N, typename E>
-std::optional<Graph<N,E>> compute_SP_Dijkstra(Graph<N,E> const& graph, int const fromId, int const toId) {
-    //You should check for negative cycles, and that from and to are actually part of the same graph
-    
-    //label all nodes as not part of the path
-    Graph<N,E> const& directg = myGraphUtils::makeDirect(graph);
-    Graph<N,E> sp; //shortest path
-    std::unordered_map<int, bool> flag;
-    std::unordered_map<int, E> min;
-    std::unordered_map<int, Edge<E>> prev; //for a given node id, it tells which node preceedes it and with what weight on the edge
-    std::priority_queue<Edge<E>, std::vector<Edge<E>>, std::greater<Edge<E>>> edgesQueue;
-    for (Node<N,E> const& n : directg.getNodes())
-    {
-        min.insert_or_assign(n.getId(), std::numeric_limits<E>().max());
-        flag.insert_or_assign(n.getId(), false);
+std::optional<Path<E>> compute_SP_Dijkstra(Graph<N,E> const& graph, int const fromId, int const toId) {
+    return compute_SP_Dijkstra(graph.freeze(), fromId, toId);
+}
+
+/* The state of Dijkstra's algorithm (the result arrays, an indexed 4-ary heap and the target marks), kept between
+   searches: once sized for a graph, back-to-back searches on it allocate nothing and only reset the nodes
+   the previous search reached */
+template <typename E>
+class DijkstraWorkspace {
+    private:
+        ShortestPathTree<E> tree;
+        DaryHeap<E> queue;
+        std::vector<int> touched;       //nodes whose state differs from the initial one
+        std::vector<bool> targets;
+        void reset(int const numNodes);
+    public:
+        DijkstraWorkspace() = default;
+        ShortestPathTree<E> const& getTree() const;
+        template <typename N>
+        ShortestPathTree<E> const& search(CsrGraph<N,E> const& graph, int const from, std::vector<int> const& targetIndices);
+        template <typename N, typename P>
+        ShortestPathTree<E> const& search(CsrGraph<N,E> const& graph, int const from, int const* const targetIndices,
+                                          size_t const numTargets, P const& potential);
+};
+
+template <typename E>
+void DijkstraWorkspace<E>::reset(int const numNodes) {
+    if(tree.getNumNodes() != numNodes) {
+        tree.distances.assign(numNodes, std::numeric_limits<E>().max());
+        tree.predecessors.assign(numNodes, -1);
+        tree.arcs.assign(numNodes, 0);
+        tree.settled.assign(numNodes, false);
+        targets.assign(numNodes, false);
+        queue.resize(numNodes);
+        touched.clear();
+        touched.reserve(numNodes);
+        return;
+    }
+    for (int const node : touched) {
+        tree.distances[node] = std::numeric_limits<E>().max();
+        tree.predecessors[node] = -1;
+        tree.settled[node] = false;
+    }
+    touched.clear();
+    queue.clear();
+}
+
+template <typename E>
+ShortestPathTree<E> const& DijkstraWorkspace<E>::getTree() const {
+    return tree;
+}
+
+/* Runs Dijkstra's algorithm from the node with index "from", until every node in targetIndices is settled
+   (every reachable node if there are no targets). Returns the tree, which stays valid until the next search */
+template <typename E>
+template <typename N>
+ShortestPathTree<E> const& DijkstraWorkspace<E>::search(CsrGraph<N,E> const& graph, int const from, std::vector<int> const& targetIndices) {
+    return search(graph, from, targetIndices.data(), targetIndices.size(), [](int const) { return E(0); });
+}
+
+/* Runs A* from the node with index "from", until every target is settled: nodes are popped by distance plus
+   potential(node), a lower bound of their distance to the targets. The potential must be consistent
+   (potential(u) <= cost(u,v) + potential(v)), so that a node is never improved once settled; a zero potential is Dijkstra */
+template <typename E>
+template <typename N, typename P>
+ShortestPathTree<E> const& DijkstraWorkspace<E>::search(CsrGraph<N,E> const& graph, int const from, int const* const targetIndices,
+                                                        size_t const numTargets, P const& potential) {
+    GRAPH_STATS_SCOPE("DijkstraWorkspace::search");
+    reset(graph.getNumNodes());
+    tree.source = from;
+    size_t remaining = 0;
+    for (size_t t = 0; t < numTargets; t++) {
+        int const target = targetIndices[t];
+        if(!targets[target]) {
+            targets[target] = true;
+            remaining++;
+        }
+    }
+    tree.distances[from] = 0;
+    touched.push_back(from);
+    queue.push(from, potential(from));
+    while(!queue.empty()) {
+        int const current = queue.pop().second;
+        E const distance = tree.distances[current];
+        tree.settled[current] = true;
+        GRAPH_STATS_ADD(SETTLED, 1);
+        if(targets[current]) {
+            targets[current] = false;
+            if(--remaining == 0) {
+                break;
+            }
+        }
+        GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(current) - graph.arcsBegin(current));
+        for (unsigned int arc = graph.arcsBegin(current); arc < graph.arcsEnd(current); arc++)
+        {
+            int const target = graph.getTarget(arc);
+            E const cost = distance + graph.getCost(arc);
+            if(!tree.settled[target] && cost < tree.distances[target]) {
+                if(tree.predecessors[target] == -1 && target != from) {
+                    touched.push_back(target);
+                }
+                tree.distances[target] = cost;
+                tree.predecessors[target] = current;
+                tree.arcs[target] = arc;
+                queue.pushOrDecrease(target, cost + potential(target));
+            }
+        }
+    }
+    //Targets which were not reached keep their mark otherwise
+    for (size_t t = 0; t < numTargets; t++) {
+        targets[targetIndices[t]] = false;
+    }
+    return tree;
+}
+
+/* Computes the shortest paths from a node to every other one using Dijkstra's algorithm with an indexed d-ary heap
+    Parameters:
+        -graph:     a reference to the frozen graph
+        -fromId:    the id of the starting node
+        -workspace: the state reused between searches, which holds the result
+    Returns: the distance and predecessor of every node (by index), valid until the next search with the same workspace */
+template <typename N, typename E>
+ShortestPathTree<E> const& compute_SPT_Dijkstra(CsrGraph<N,E> const& graph, int const fromId, DijkstraWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SPT_Dijkstra");
+    return workspace.search(graph, graph.getIndex(fromId), {});
+}
+
+/* Computes the shortest paths from a node to some others using Dijkstra's algorithm with an indexed d-ary heap,
+   stopping as soon as all of them are settled
+    Parameters:
+        -graph:     a reference to the frozen graph
+        -fromId:    the id of the starting node
+        -toIds:     the ids of the end nodes
+        -workspace: the state reused between searches, which holds the result
+    Returns: the distance and predecessor of every settled node (by index), valid until the next search with the same workspace */
+template <typename N, typename E>
+ShortestPathTree<E> const& compute_SPT_Dijkstra(CsrGraph<N,E> const& graph, int const fromId, std::vector<int> const& toIds, DijkstraWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SPT_Dijkstra");
+    std::vector<int> targets;
+    targets.reserve(toIds.size());
+    for (int const id : toIds) {
+        targets.push_back(graph.getIndex(id));
+    }
+    return workspace.search(graph, graph.getIndex(fromId), targets);
+}
+
+/* Computes the shortest paths from a node to every other one using Dijkstra's algorithm, see the workspace overload */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT_Dijkstra(CsrGraph<N,E> const& graph, int const fromId) {
+    DijkstraWorkspace<E> workspace;
+    return compute_SPT_Dijkstra(graph, fromId, workspace);
+}
+
+/* Computes the shortest paths from a node to every other one using Dijkstra's algorithm. The indices in the result
+   are the ones of the graph (see Graph::getIndex); for repeated searches freeze the graph once and pass a workspace */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT_Dijkstra(Graph<N,E> const& graph, int const fromId) {
+    return compute_SPT_Dijkstra(graph.freeze(), fromId);
+}
+
+
+//Largest number of buckets delta-stepping keeps: a smaller delta is widened, so that the cyclic array of buckets
+//(and the walk over its empty ones) stays bounded whatever the largest cost
+constexpr size_t DELTA_STEPPING_MAX_BUCKETS = 1 << 16;
+
+/* Picks the bucket width of delta-stepping from the costs of the arcs: the largest cost over the average degree,
+   so that a node has about one light arc for each heavy one, but never below the smallest positive cost */
+template <typename N, typename E>
+E deltaSteppingWidth(CsrGraph<N,E> const& graph) {
+    E const maxCost = graph.getMaxCost();
+    if(maxCost <= 0) {
+        return 1;
+    }
+    E minCost = graph.getMinCost();
+    if(minCost <= 0) {
+        //Zero cost arcs never need a bucket of their own: the smallest positive cost is the one that matters
+        minCost = maxCost;
+        for (unsigned int arc = 0; arc < graph.getNumArcs(); arc++) {
+            E const cost = graph.getCost(arc);
+            if(cost > 0) {
+                minCost = std::min(minCost, cost);
+            }
+        }
+    }
+    double const degree = std::max(1.0, (double)graph.getNumArcs() / std::max(1, graph.getNumNodes()));
+    return std::max(minCost, (E)(maxCost / degree));
+}
+
+/* Atomically lowers distance to candidate, returns whether it did */
+template <typename E>
+static bool atomicMin(std::atomic<E>& distance, E const candidate) {
+    E current = distance.load(std::memory_order_relaxed);
+    while(candidate < current) {
+        if(distance.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Computes the shortest paths from a node to every other one using parallel delta-stepping.
+   Nodes are kept in buckets of width delta by tentative distance; the nodes of the lowest bucket relax their light
+   arcs (cost <= delta) in parallel until the bucket stops refilling, then all the nodes it held relax their heavy arcs.
+   The buckets are a cyclic array, since pending distances are never more than the largest cost ahead.
+   The distances are the ones Dijkstra finds; the predecessors are then chosen among the arcs which are tight,
+   visiting them breadth first from the source, so that zero cost cycles can not make them point at each other
+    Parameters:
+        -graph:      a reference to the frozen graph, it must not have negative costs (std::invalid_argument is thrown)
+        -fromId:     the id of the starting node
+        -delta:      the width of the buckets, 0 picks it from the costs (see deltaSteppingWidth); it is widened to at
+                     least the largest cost over DELTA_STEPPING_MAX_BUCKETS
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: the distance and predecessor of every node (by index) */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT_Delta_Stepping(CsrGraph<N,E> const& graph, int const fromId, E delta = 0, unsigned int const numThreads = 0) {
+    GRAPH_STATS_SCOPE("compute_SPT_Delta_Stepping");
+    int const numNodes = graph.getNumNodes();
+    int const from = graph.getIndex(fromId);
+    E const max = std::numeric_limits<E>().max();
+    if(graph.getMinCost() < 0) {
+        throw std::invalid_argument("delta-stepping needs non negative costs");
+    }
+    E const maxCost = graph.getMaxCost();
+    if(!(delta > 0)) {
+        delta = deltaSteppingWidth(graph);
+    }
+    if(maxCost / delta > E(DELTA_STEPPING_MAX_BUCKETS - 4)) {
+        //Rounded up for integral costs, a little over the bound for floating point ones
+        delta = maxCost / E(DELTA_STEPPING_MAX_BUCKETS - 4) + (std::is_integral_v<E> ? E(1) : E(0));
+    }
+    size_t const numBuckets = (size_t)(maxCost / delta) + 2;
+    auto bucketOf = [delta](E const distance) { return (size_t)(distance / delta); };
+    GRAPH_STATS_PHASE("buckets");
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<std::atomic<E>> distances(numNodes, scratch);
+    for (std::atomic<E>& d : distances) {
+        d.store(max, std::memory_order_relaxed);
+    }
+    ScratchVector<ScratchVector<int>> buckets(numBuckets, scratch);
+    ScratchVector<bool> inFrontier(numNodes, false, scratch), inSettled(numNodes, false, scratch);
+    ScratchVector<int> frontier(scratch), settled(scratch);
+    size_t const grain = 1024;
+    std::vector<std::vector<int>> reached; //per chunk of the frontier, the nodes whose distance went down (filled by the workers, so not scratch)
+    //Relaxes the light (or heavy) arcs of nodes[begin..end), collecting the improved nodes in "out"
+    auto relax = [&](ScratchVector<int> const& nodes, size_t const begin, size_t const end, bool const light, std::vector<int>& out) {
+        for (size_t i = begin; i < end; i++) {
+            int const node = nodes[i];
+            E const distance = distances[node].load(std::memory_order_relaxed);
+            GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(node) - graph.arcsBegin(node));
+            for (unsigned int arc = graph.arcsBegin(node); arc < graph.arcsEnd(node); arc++) {
+                E const cost = graph.getCost(arc);
+                if((cost <= delta) == light && atomicMin(distances[graph.getTarget(arc)], distance + cost)) {
+                    out.push_back(graph.getTarget(arc));
+                }
+            }
+        }
+    };
+    auto relaxAll = [&](ScratchVector<int> const& nodes, bool const light) {
+        reached.resize((nodes.size() + grain - 1) / grain);
+        myGraphUtils::parallelForChunks(0, nodes.size(), [&](size_t const begin, size_t const end) {
+            std::vector<int>& out = reached[begin / grain];
+            out.clear();
+            relax(nodes, begin, end, light, out);
+        }, numThreads, grain);
+        for (std::vector<int> const& out : reached) {
+            GRAPH_STATS_ADD(HEAP_PUSHES, out.size());
+            for (int const node : out) {
+                buckets[bucketOf(distances[node].load(std::memory_order_relaxed)) % numBuckets].push_back(node);
+            }
+        }
+    };
+    distances[from].store(0, std::memory_order_relaxed);
+    buckets[0].push_back(from);
+    GRAPH_STATS_ADD(HEAP_PUSHES, 1);
+    for (size_t current = 0, empty = 0; empty < numBuckets; current++) {
+        ScratchVector<int>& bucket = buckets[current % numBuckets];
+        if(bucket.empty()) {
+            empty++;
+            continue;
+        }
+        empty = 0;
+        settled.clear();
+        while(!bucket.empty()) {
+            //Entries are stale if the node has since moved to a lower bucket, or is already in the frontier
+            frontier.clear();
+            GRAPH_STATS_ADD(HEAP_POPS, bucket.size());
+            for (int const node : bucket) {
+                if(!inFrontier[node] && bucketOf(distances[node].load(std::memory_order_relaxed)) == current) {
+                    inFrontier[node] = true;
+                    frontier.push_back(node);
+                    if(!inSettled[node]) {
+                        inSettled[node] = true;
+                        settled.push_back(node);
+                    }
+                }
+            }
+            GRAPH_STATS_ADD(STALE_POPS, bucket.size() - frontier.size());
+            bucket.clear();
+            for (int const node : frontier) {
+                inFrontier[node] = false;
+            }
+            relaxAll(frontier, true);
+        }
+        GRAPH_STATS_ADD(SETTLED, settled.size());
+        relaxAll(settled, false);
+        for (int const node : settled) {
+            inSettled[node] = false;
+        }
+    }
+    //Choosing the predecessors among the tight arcs, level by level from the source
+    GRAPH_STATS_PHASE("predecessors");
+    std::vector<E> result(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+        result[i] = distances[i].load(std::memory_order_relaxed);
+    }
+    std::vector<int> predecessors(numNodes, -1);
+    std::vector<unsigned int> arcs(numNodes, 0);
+    ScratchVector<bool> visited(numNodes, false, scratch);
+    visited[from] = true;
+    frontier.assign(1, from);
+    for (size_t head = 0; head < frontier.size(); head++) {
+        int const node = frontier[head];
+        for (unsigned int arc = graph.arcsBegin(node); arc < graph.arcsEnd(node); arc++) {
+            int const target = graph.getTarget(arc);
+            if(!visited[target] && result[node] + graph.getCost(arc) == result[target]) {
+                visited[target] = true;
+                predecessors[target] = node;
+                arcs[target] = arc;
+                frontier.push_back(target);
+            }
+        }
+    }
+    return ShortestPathTree<E>(from, std::move(result), std::move(predecessors), std::move(arcs));
+}
+
+/* Computes the shortest paths from a node to every other one using parallel delta-stepping, see the CsrGraph overload */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT_Delta_Stepping(Graph<N,E> const& graph, int const fromId, E const delta = 0, unsigned int const numThreads = 0) {
+    return compute_SPT_Delta_Stepping(graph.freeze(), fromId, delta, numThreads);
+}
+
+//Largest arc cost Dial's algorithm takes (std::invalid_argument is thrown above), and up to which compute_SPT picks it
+//by itself: there is one bucket per distance unit of the largest cost, walked one at a time, so with larger costs the
+//empty ones cost more than the heap operations they save
+constexpr long long DIAL_MAX_COST = 1 << 14;
+
+/* The state of a breadth first search (the result arrays, the queue and the target marks), kept between searches
+   like DijkstraWorkspace: the queue holds the nodes the previous search reached, the only ones to reset */
+template <typename E>
+class BFSWorkspace {
+    private:
+        ShortestPathTree<E> tree;
+        std::vector<int> queue;
+        std::vector<bool> targets;
+        void reset(int const numNodes);
+    public:
+        BFSWorkspace() = default;
+        ShortestPathTree<E> const& getTree() const;
+        template <typename N>
+        ShortestPathTree<E> const& search(CsrGraph<N,E> const& graph, int const from, int const* const targetIndices, size_t const numTargets);
+};
+
+template <typename E>
+void BFSWorkspace<E>::reset(int const numNodes) {
+    if(tree.getNumNodes() != numNodes) {
+        tree.distances.assign(numNodes, std::numeric_limits<E>().max());
+        tree.predecessors.assign(numNodes, -1);
+        tree.arcs.assign(numNodes, 0);
+        tree.settled.assign(numNodes, false);
+        targets.assign(numNodes, false);
+        queue.clear();
+        queue.reserve(numNodes);
+        return;
+    }
+    for (int const node : queue) {
+        tree.distances[node] = std::numeric_limits<E>().max();
+        tree.predecessors[node] = -1;
+        tree.settled[node] = false;
+    }
+    queue.clear();
+}
+
+template <typename E>
+ShortestPathTree<E> const& BFSWorkspace<E>::getTree() const {
+    return tree;
+}
+
+/* Runs a breadth first search from the node with index "from", until every node in targetIndices is settled (every
+   reachable node if there are no targets). A node is settled as soon as it is first reached, at the cost of one more
+   arc than its predecessor: every arc of the graph must have that same non negative cost, which the caller checks.
+   Returns the tree, which stays valid until the next search */
+template <typename E>
+template <typename N>
+ShortestPathTree<E> const& BFSWorkspace<E>::search(CsrGraph<N,E> const& graph, int const from, int const* const targetIndices,
+                                                   size_t const numTargets) {
+    GRAPH_STATS_SCOPE("BFSWorkspace::search");
+    reset(graph.getNumNodes());
+    tree.source = from;
+    E const cost = graph.getMinCost();
+    size_t remaining = 0;
+    for (size_t t = 0; t < numTargets; t++) {
+        int const target = targetIndices[t];
+        if(!targets[target]) {
+            targets[target] = true;
+            remaining++;
+        }
+    }
+    //Settles a node, returns whether it was the last target
+    auto settle = [&](int const node) {
+        tree.settled[node] = true;
+        queue.push_back(node);
+        if(targets[node]) {
+            targets[node] = false;
+            return --remaining == 0;
+        }
+        return false;
+    };
+    tree.distances[from] = 0;
+    bool done = settle(from);
+    for (size_t head = 0; head < queue.size() && !done; head++) {
+        int const current = queue[head];
+        GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(current) - graph.arcsBegin(current));
+        for (unsigned int arc = graph.arcsBegin(current); arc < graph.arcsEnd(current) && !done; arc++) {
+            int const target = graph.getTarget(arc);
+            if(!tree.settled[target]) {
+                tree.distances[target] = tree.distances[current] + cost;
+                tree.predecessors[target] = current;
+                tree.arcs[target] = arc;
+                done = settle(target);
+            }
+        }
+    }
+    GRAPH_STATS_ADD(SETTLED, queue.size());
+    //Targets which were not reached keep their mark otherwise
+    for (size_t t = 0; t < numTargets; t++) {
+        targets[targetIndices[t]] = false;
+    }
+    return tree;
+}
+
+/* The state of Dial's algorithm (the result arrays, the cyclic array of buckets and the target marks), kept between
+   searches like DijkstraWorkspace. A search leaves every bucket empty, so only the nodes it reached are reset */
+template <typename E>
+class DialWorkspace {
+    private:
+        ShortestPathTree<E> tree;
+        std::vector<std::vector<int>> buckets;      //by tentative distance, modulo their number
+        std::vector<int> touched;                   //nodes whose state differs from the initial one
+        std::vector<bool> targets;
+        void reset(int const numNodes, size_t const numBuckets);
+    public:
+        DialWorkspace() = default;
+        ShortestPathTree<E> const& getTree() const;
+        template <typename N>
+        ShortestPathTree<E> const& search(CsrGraph<N,E> const& graph, int const from, int const* const targetIndices, size_t const numTargets);
+};
+
+template <typename E>
+void DialWorkspace<E>::reset(int const numNodes, size_t const numBuckets) {
+    if(buckets.size() != numBuckets) {
+        buckets.clear();
+        buckets.resize(numBuckets);
+    }
+    if(tree.getNumNodes() != numNodes) {
+        tree.distances.assign(numNodes, std::numeric_limits<E>().max());
+        tree.predecessors.assign(numNodes, -1);
+        tree.arcs.assign(numNodes, 0);
+        tree.settled.assign(numNodes, false);
+        targets.assign(numNodes, false);
+        touched.clear();
+        touched.reserve(numNodes);
+        return;
+    }
+    for (int const node : touched) {
+        tree.distances[node] = std::numeric_limits<E>().max();
+        tree.predecessors[node] = -1;
+        tree.settled[node] = false;
     }
+    touched.clear();
+}
+
+template <typename E>
+ShortestPathTree<E> const& DialWorkspace<E>::getTree() const {
+    return tree;
+}
+
+/* Runs Dial's algorithm from the node with index "from", until every node in targetIndices is settled (every
+   reachable node if there are no targets). The nodes are kept in buckets by tentative distance instead of a heap, and
+   the buckets are walked in order of distance. Pending distances are never more than the largest cost ahead of the
+   current one, so a cyclic array of that many buckets is enough. A node is pushed again when its distance goes down,
+   the older entries are skipped. The costs must be integral, non negative and at most DIAL_MAX_COST, which the
+   caller checks. Returns the tree, which stays valid until the next search */
+template <typename E>
+template <typename N>
+ShortestPathTree<E> const& DialWorkspace<E>::search(CsrGraph<N,E> const& graph, int const from, int const* const targetIndices,
+                                                    size_t const numTargets) {
+    static_assert(std::is_integral_v<E>, "Dial's algorithm needs integral costs");
+    GRAPH_STATS_SCOPE("DialWorkspace::search");
+    size_t const numBuckets = (size_t)graph.getMaxCost() + 1;
+    reset(graph.getNumNodes(), numBuckets);
+    tree.source = from;
+    size_t remaining = 0;
+    for (size_t t = 0; t < numTargets; t++) {
+        int const target = targetIndices[t];
+        if(!targets[target]) {
+            targets[target] = true;
+            remaining++;
+        }
+    }
+    tree.distances[from] = 0;
+    touched.push_back(from);
+    buckets[0].push_back(from);
+    GRAPH_STATS_ADD(HEAP_PUSHES, 1);
+    size_t pending = 1;
+    for (E current = 0; pending > 0; current++) {
+        //Zero cost arcs push to the bucket being walked, so it is walked by position
+        std::vector<int>& bucket = buckets[(size_t)current % numBuckets];
+        for (size_t i = 0; i < bucket.size(); i++) {
+            int const node = bucket[i];
+            pending--;
+            GRAPH_STATS_ADD(HEAP_POPS, 1);
+            if(tree.settled[node] || tree.distances[node] != current) {
+                GRAPH_STATS_ADD(STALE_POPS, 1);
+                continue;
+            }
+            tree.settled[node] = true;
+            GRAPH_STATS_ADD(SETTLED, 1);
+            if(targets[node]) {
+                targets[node] = false;
+                if(--remaining == 0) {
+                    //The entries left are dropped: they all lie within the largest cost ahead
+                    pending -= bucket.size() - i - 1;
+                    bucket.clear();
+                    for (E next = current + 1; pending > 0; next++) {
+                        std::vector<int>& later = buckets[(size_t)next % numBuckets];
+                        pending -= later.size();
+                        later.clear();
+                    }
+                    break;
+                }
+            }
+            GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(node) - graph.arcsBegin(node));
+            for (unsigned int arc = graph.arcsBegin(node); arc < graph.arcsEnd(node); arc++) {
+                int const target = graph.getTarget(arc);
+                E const distance = current + graph.getCost(arc);
+                if(distance < tree.distances[target]) {
+                    if(tree.distances[target] == std::numeric_limits<E>().max()) {
+                        touched.push_back(target);
+                    }
+                    tree.distances[target] = distance;
+                    tree.predecessors[target] = node;
+                    tree.arcs[target] = arc;
+                    buckets[(size_t)distance % numBuckets].push_back(target);
+                    pending++;
+                    GRAPH_STATS_ADD(HEAP_PUSHES, 1);
+                }
+            }
+        }
+        bucket.clear();
+    }
+    //Targets which were not reached keep their mark otherwise
+    for (size_t t = 0; t < numTargets; t++) {
+        targets[targetIndices[t]] = false;
+    }
+    return tree;
+}
+
+/* The single source shortest path engines:
+    -SP_DIJKSTRA:       sequential, with an indexed d-ary heap
+    -SP_DELTA_STEPPING: parallel, for non negative costs
+    -SP_BFS:            sequential breadth first search, when every arc has the same non negative cost
+    -SP_DIAL:           sequential, with buckets instead of a heap, for non negative integral costs
+    -SP_AUTO:           the one chooseShortestPathEngine picks */
+enum ShortestPathEngine {SP_DIJKSTRA, SP_DELTA_STEPPING, SP_BFS, SP_DIAL, SP_AUTO};
 
-    //Start from "from", add all of the edges starting from it to the queue
-    Node<N,E> current = directg.getNode(fromId);
-    for (auto const& e : current.getAdjacentEdges()) {
-        if(min.at(e.getTo()) > e.getCost()) {
-            min.insert_or_assign(e.getTo(), e.getCost());
-            edgesQueue.push(e);
-            prev.insert_or_assign(e.getTo(), e);
+/* Throws std::invalid_argument unless the engine can run on the costs of the graph; Dijkstra and delta-stepping
+   check their own */
+template <typename N, typename E>
+void checkShortestPathEngine(CsrGraph<N,E> const& graph, ShortestPathEngine const engine) {
+    if(engine == SP_BFS && !(graph.hasUniformCost() && graph.getMinCost() >= 0)) {
+        throw std::invalid_argument("a breadth first search needs every arc to have the same non negative cost");
+    }
+    if(engine == SP_DIAL) {
+        if(!std::is_integral_v<E>) {
+            throw std::invalid_argument("Dial's algorithm needs integral costs");
+        }
+        if(graph.getMinCost() < 0) {
+            throw std::invalid_argument("Dial's algorithm needs non negative costs");
+        }
+        if((long long)graph.getMaxCost() > DIAL_MAX_COST) {
+            throw std::invalid_argument("Dial's algorithm needs costs of at most DIAL_MAX_COST");
         }
     }
-    min.insert_or_assign(current.getId(), 0);
-    while(current.getId() != toId && !edgesQueue.empty()) {
-        Edge<E> best;
-        do {
-            best = edgesQueue.top();
-            edgesQueue.pop();
-        } while(flag.at(best.getTo()));
-        current = directg.getNode(best.getTo());
+}
+
+/* Computes the shortest paths from a node with a breadth first search, for graphs where every arc has the same cost
+   (like the ones GraphBuilder makes without edge weights): a node is settled as soon as it is first reached, so no
+   priority queue is needed at all
+    Parameters:
+        -graph:     a reference to the frozen graph, every arc must have the same non negative cost (std::invalid_argument is thrown)
+        -fromId:    the id of the starting node
+        -toIds:     the ids of the end nodes, the search stops as soon as they are all settled; empty for every node
+        -workspace: the state reused between searches, which holds the result
+    Returns: the distance and predecessor of every settled node (by index), valid until the next search with the same workspace */
+template <typename N, typename E>
+ShortestPathTree<E> const& compute_SPT_BFS(CsrGraph<N,E> const& graph, int const fromId, std::vector<int> const& toIds, BFSWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SPT_BFS");
+    checkShortestPathEngine(graph, SP_BFS);
+    std::vector<int> targets;
+    targets.reserve(toIds.size());
+    for (int const id : toIds) {
+        targets.push_back(graph.getIndex(id));
+    }
+    return workspace.search(graph, graph.getIndex(fromId), targets.data(), targets.size());
+}
+
+/* Computes the shortest paths from a node with a breadth first search, see the workspace overload */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT_BFS(CsrGraph<N,E> const& graph, int const fromId, std::vector<int> const& toIds = {}) {
+    BFSWorkspace<E> workspace;
+    return compute_SPT_BFS(graph, fromId, toIds, workspace);
+}
 
-        for (Edge<E> const& e : current.getAdjacentEdges())
+/* Computes the shortest paths from a node using Dial's algorithm, for small integral costs (see DialWorkspace::search)
+    Parameters:
+        -graph:     a reference to the frozen graph, its costs must be non negative and at most DIAL_MAX_COST
+                    (std::invalid_argument is thrown)
+        -fromId:    the id of the starting node
+        -toIds:     the ids of the end nodes, the search stops as soon as they are all settled; empty for every node
+        -workspace: the state reused between searches, which holds the result
+    Returns: the distance and predecessor of every settled node (by index), valid until the next search with the same workspace */
+template <typename N, typename E>
+ShortestPathTree<E> const& compute_SPT_Dial(CsrGraph<N,E> const& graph, int const fromId, std::vector<int> const& toIds, DialWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SPT_Dial");
+    checkShortestPathEngine(graph, SP_DIAL);
+    std::vector<int> targets;
+    targets.reserve(toIds.size());
+    for (int const id : toIds) {
+        targets.push_back(graph.getIndex(id));
+    }
+    return workspace.search(graph, graph.getIndex(fromId), targets.data(), targets.size());
+}
+
+/* Computes the shortest paths from a node using Dial's algorithm, see the workspace overload */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT_Dial(CsrGraph<N,E> const& graph, int const fromId, std::vector<int> const& toIds = {}) {
+    DialWorkspace<E> workspace;
+    return compute_SPT_Dial(graph, fromId, toIds, workspace);
+}
+
+/* Picks the sequential engine suiting the cost type and the costs of the graph:
+    -SP_BFS when every arc has the same non negative cost
+    -SP_DIAL when the costs are integral, non negative and at most DIAL_MAX_COST
+    -SP_DIJKSTRA otherwise, which is always the case with negative or floating point costs of different values
+   It only reads the smallest and largest costs the snapshot keeps, so it is constant time
+    Parameters:
+        -graph: a reference to the frozen graph
+    Returns: the engine, never SP_AUTO */
+template <typename N, typename E>
+ShortestPathEngine chooseShortestPathEngine(CsrGraph<N,E> const& graph) {
+    if(graph.getMinCost() < 0) {
+        return SP_DIJKSTRA;
+    }
+    if(graph.hasUniformCost()) {
+        return SP_BFS;
+    }
+    if constexpr (std::is_integral_v<E>) {
+        if((long long)graph.getMaxCost() <= DIAL_MAX_COST) {
+            return SP_DIAL;
+        }
+    }
+    return SP_DIJKSTRA;
+}
+
+/* Computes the shortest paths from a node to every other one with the given engine; they all find the same distances
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -fromId:     the id of the starting node
+        -engine:     the algorithm to use, see ShortestPathEngine; std::invalid_argument is thrown if the costs do not suit
+                     it, for SP_DIAL when they are floating point or above DIAL_MAX_COST
+        -numThreads: the number of threads the parallel engines use, 0 means one per hardware thread
+    Returns: the distance and predecessor of every node (by index) */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT(CsrGraph<N,E> const& graph, int const fromId, ShortestPathEngine engine = SP_AUTO, unsigned int const numThreads = 0) {
+    if(engine == SP_AUTO) {
+        engine = chooseShortestPathEngine(graph);
+    }
+    checkShortestPathEngine(graph, engine);
+    switch(engine) {
+        case SP_DELTA_STEPPING:
+            return compute_SPT_Delta_Stepping(graph, fromId, E(0), numThreads);
+        case SP_BFS:
+            return compute_SPT_BFS(graph, fromId);
+        case SP_DIAL:
+            if constexpr (std::is_integral_v<E>) {
+                return compute_SPT_Dial(graph, fromId);
+            } else {
+                throw std::invalid_argument("Dial's algorithm needs integral costs");
+            }
+        case SP_DIJKSTRA:
+        default:
+            return compute_SPT_Dijkstra(graph, fromId);
+    }
+}
+
+/* Computes the shortest paths from a node to every other one with the given engine, see the CsrGraph overload */
+template <typename N, typename E>
+ShortestPathTree<E> compute_SPT(Graph<N,E> const& graph, int const fromId, ShortestPathEngine const engine = SP_AUTO, unsigned int const numThreads = 0) {
+    return compute_SPT(graph.freeze(), fromId, engine, numThreads);
+}
+
+/* Computes the shortest path using Dijkstra's algorithm on a CSR snapshot of the graph
+    Parameters:
+        -graph:  a reference to the frozen graph
+        -fromId: the id of the starting node
+        -toId:   the id of the end node
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_Dijkstra(CsrGraph<N,E> const& graph, int const fromId, int const toId) {
+    GRAPH_STATS_SCOPE("compute_SP_Dijkstra");
+    //You should check for negative cycles
+    DijkstraWorkspace<E> workspace;
+    return makePath(graph, compute_SPT_Dijkstra(graph, fromId, std::vector<int>{toId}, workspace), graph.getIndex(toId));
+}
+
+/* Builds the path the tree holds from its source to the node with index "to"
+    Returns: an optional containing the path, empty if the node was not reached */
+template <typename N, typename E>
+std::optional<Path<E>> makePath(CsrGraph<N,E> const& graph, ShortestPathTree<E> const& tree, int const to) {
+    if(!tree.isReachable(to)) {
+        return {};
+    }
+    std::vector<unsigned int> arcs;
+    for (int current = to; current != tree.getSource(); current = tree.getPredecessor(current)) {
+        arcs.push_back(tree.getPredecessorArc(current));
+    }
+    std::reverse(arcs.begin(), arcs.end());
+    return graph.makePath(tree.getSource(), arcs);
+}
+
+/* The workspaces of the sequential engines, for repeated point to point searches with compute_SP whatever the engine:
+   each one is only sized for the graph once its engine runs */
+template <typename E>
+struct ShortestPathWorkspace {
+    DijkstraWorkspace<E> dijkstra;
+    BFSWorkspace<E> bfs;
+    DialWorkspace<E> dial;
+};
+
+/* Computes the shortest path between two nodes with the given engine (see compute_SPT); the sequential ones stop as
+   soon as the end node is settled, and with a workspace kept between calls they only touch the nodes they reach
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -fromId:     the id of the starting node
+        -toId:       the id of the end node
+        -workspace:  the state of the sequential engines, reused between searches
+        -engine:     the algorithm to use, see ShortestPathEngine; std::invalid_argument is thrown if the costs do not suit it
+        -numThreads: the number of threads the parallel engines use, 0 means one per hardware thread
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP(CsrGraph<N,E> const& graph, int const fromId, int const toId, ShortestPathWorkspace<E>& workspace,
+                                  ShortestPathEngine engine = SP_AUTO, unsigned int const numThreads = 0) {
+    if(engine == SP_AUTO) {
+        engine = chooseShortestPathEngine(graph);
+    }
+    checkShortestPathEngine(graph, engine);
+    int const from = graph.getIndex(fromId), to = graph.getIndex(toId);
+    switch(engine) {
+        case SP_DELTA_STEPPING:
+            return makePath(graph, compute_SPT_Delta_Stepping(graph, fromId, E(0), numThreads), to);
+        case SP_BFS:
+            return makePath(graph, workspace.bfs.search(graph, from, &to, 1), to);
+        case SP_DIAL:
+            if constexpr (std::is_integral_v<E>) {
+                return makePath(graph, workspace.dial.search(graph, from, &to, 1), to);
+            } else {
+                throw std::invalid_argument("Dial's algorithm needs integral costs");
+            }
+        case SP_DIJKSTRA:
+        default:
+            return makePath(graph, workspace.dijkstra.search(graph, from, &to, 1, [](int const) { return E(0); }), to);
+    }
+}
+
+/* Computes the shortest path between two nodes with the given engine, see the workspace overload */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP(CsrGraph<N,E> const& graph, int const fromId, int const toId, ShortestPathEngine const engine = SP_AUTO,
+                                  unsigned int const numThreads = 0) {
+    ShortestPathWorkspace<E> workspace;
+    return compute_SP(graph, fromId, toId, workspace, engine, numThreads);
+}
+
+/* Computes the shortest path between two nodes with the given engine, see the CsrGraph overload */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP(Graph<N,E> const& graph, int const fromId, int const toId, ShortestPathEngine const engine = SP_AUTO,
+                                  unsigned int const numThreads = 0) {
+    return compute_SP(graph.freeze(), fromId, toId, engine, numThreads);
+}
+
+/* Computes the shortest path of every (from, to) query using Dijkstra's algorithm. The queries sharing a source are
+   answered by one search, stopping once all their targets are settled; the sources are spread over one thread per
+   workspace, each reusing its own from one search to the next. Keeping the workspaces from one batch to the next
+   saves sizing them again for the graph
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -queries:    the (from id, to id) pairs, it throws std::out_of_range if an id is not in the graph
+        -workspaces: the workspaces of the threads, it throws std::invalid_argument if there are queries but none
+    Returns: for every query, in the same order, an optional containing the shortest path (see Path::toGraph), empty if the
+             end node can not be reached */
+template <typename N, typename E>
+std::vector<std::optional<Path<E>>> compute_SP_Dijkstra_Batch(CsrGraph<N,E> const& graph, std::vector<std::pair<int,int>> const& queries,
+                                                                  std::vector<DijkstraWorkspace<E>>& workspaces) {
+    GRAPH_STATS_SCOPE("compute_SP_Dijkstra_Batch");
+    if(workspaces.empty() && !queries.empty()) {
+        throw std::invalid_argument("a batch of queries needs at least one workspace");
+    }
+    //(from index, to index) of every query, then the queries ordered by source, and where each source starts
+    std::vector<std::pair<int,int>> ends(queries.size());
+    for (size_t q = 0; q < queries.size(); q++) {
+        ends[q] = {graph.getIndex(queries[q].first), graph.getIndex(queries[q].second)};
+    }
+    std::vector<unsigned int> order(queries.size());
+    for (size_t q = 0; q < order.size(); q++) {
+        order[q] = q;
+    }
+    std::stable_sort(order.begin(), order.end(), [&ends](unsigned int const a, unsigned int const b) {
+        return ends[a].first < ends[b].first;
+    });
+    std::vector<size_t> groups;
+    std::vector<int> targets(order.size()); //the targets of each source, next to each other
+    for (size_t i = 0; i < order.size(); i++) {
+        if(i == 0 || ends[order[i]].first != ends[order[i - 1]].first) {
+            groups.push_back(i);
+        }
+        targets[i] = ends[order[i]].second;
+    }
+    groups.push_back(order.size());
+    std::vector<std::optional<Path<E>>> paths(queries.size());
+    GRAPH_STATS_PHASE("search");
+    std::atomic<size_t> nextWorkspace(0);
+    myGraphUtils::parallelForWithState(0, groups.size() - 1, [&]() {
+        return &workspaces[nextWorkspace++];
+    }, [&](DijkstraWorkspace<E>* const workspace, size_t const g) {
+        ShortestPathTree<E> const& tree = workspace->search(graph, ends[order[groups[g]]].first, targets.data() + groups[g],
+                                                            groups[g + 1] - groups[g], [](int const) { return E(0); });
+        for (size_t i = groups[g]; i < groups[g + 1]; i++) {
+            paths[order[i]] = makePath(graph, tree, targets[i]);
+        }
+    }, workspaces.size());
+    return paths;
+}
+
+/* Computes the shortest path of every (from, to) query using Dijkstra's algorithm, with workspaces made for this batch
+   only, see the overload taking the workspaces
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -queries:    the (from id, to id) pairs, it throws std::out_of_range if an id is not in the graph
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: for every query, in the same order, an optional containing the shortest path (see Path::toGraph), empty if the
+             end node can not be reached */
+template <typename N, typename E>
+std::vector<std::optional<Path<E>>> compute_SP_Dijkstra_Batch(CsrGraph<N,E> const& graph, std::vector<std::pair<int,int>> const& queries,
+                                                                  unsigned int const numThreads = 0) {
+    std::vector<DijkstraWorkspace<E>> workspaces(std::max<size_t>(1, std::min<size_t>(
+        numThreads > 0 ? numThreads : myGraphUtils::defaultNumThreads(), queries.size())));
+    return compute_SP_Dijkstra_Batch(graph, queries, workspaces);
+}
+
+/* Computes the shortest path of every (from, to) query using Dijkstra's algorithm, see the CsrGraph overload */
+template <typename N, typename E>
+std::vector<std::optional<Path<E>>> compute_SP_Dijkstra_Batch(Graph<N,E> const& graph, std::vector<std::pair<int,int>> const& queries,
+                                                                  unsigned int const numThreads = 0) {
+    return compute_SP_Dijkstra_Batch(graph.freeze(), queries, numThreads);
+}
+
+//The two searches of bidirectional Dijkstra: from the source on the graph, from the target on its reverse
+enum SearchDirection {FORWARD, BACKWARD};
+
+/* The state of bidirectional Dijkstra, kept between searches like DijkstraWorkspace: a forward search on the graph
+   and a backward one on its reverse (see CsrGraph::reversed), each with its own arrays and heap, run in turns until
+   they meet. After a search it tells where they met and how many nodes were settled on both sides */
+template <typename E>
+class BidirectionalWorkspace {
+    private:
+        std::vector<E> distances[2];
+        std::vector<int> predecessors[2];
+        std::vector<unsigned int> arcs[2];
+        std::vector<bool> settled[2];
+        DaryHeap<E> queues[2];
+        std::vector<int> touched[2];     //nodes whose state differs from the initial one
+        int meeting = -1;
+        E distance = std::numeric_limits<E>().max();
+        unsigned int numSettled = 0;
+        void reset(int const numNodes);
+    public:
+        BidirectionalWorkspace() = default;
+        template <typename N>
+        bool search(CsrGraph<N,E> const& graph, CsrGraph<N,E> const& reverse, int const from, int const to);
+        int getMeetingNode() const;
+        E getDistance() const;
+        unsigned int getNumSettled() const;
+        int getPredecessor(SearchDirection const direction, int const index) const;
+        unsigned int getPredecessorArc(SearchDirection const direction, int const index) const;
+};
+
+template <typename E>
+void BidirectionalWorkspace<E>::reset(int const numNodes) {
+    for (int side = FORWARD; side <= BACKWARD; side++) {
+        if((int)distances[side].size() != numNodes) {
+            distances[side].assign(numNodes, std::numeric_limits<E>().max());
+            predecessors[side].assign(numNodes, -1);
+            arcs[side].assign(numNodes, 0);
+            settled[side].assign(numNodes, false);
+            queues[side].resize(numNodes);
+            touched[side].clear();
+            touched[side].reserve(numNodes);
+            continue;
+        }
+        for (int const node : touched[side]) {
+            distances[side][node] = std::numeric_limits<E>().max();
+            predecessors[side][node] = -1;
+            settled[side][node] = false;
+        }
+        touched[side].clear();
+        queues[side].clear();
+    }
+    meeting = -1;
+    distance = std::numeric_limits<E>().max();
+    numSettled = 0;
+}
+
+/* Searches the shortest path from the node with index "from" to the one with index "to", growing a forward search
+   on graph and a backward one on reverse, always the one with the smaller frontier. It stops as soon as the sum of
+   the smallest keys of the two frontiers reaches the shortest path found so far, which then can not be improved
+   Returns: true if "to" can be reached from "from" */
+template <typename E>
+template <typename N>
+bool BidirectionalWorkspace<E>::search(CsrGraph<N,E> const& graph, CsrGraph<N,E> const& reverse, int const from, int const to) {
+    GRAPH_STATS_SCOPE("BidirectionalWorkspace::search");
+    reset(graph.getNumNodes());
+    int const starts[2] = {from, to};
+    for (int side = FORWARD; side <= BACKWARD; side++) {
+        distances[side][starts[side]] = 0;
+        touched[side].push_back(starts[side]);
+        queues[side].push(starts[side], 0);
+    }
+    if(from == to) {
+        meeting = from;
+        distance = 0;
+    }
+    while(!queues[FORWARD].empty() && !queues[BACKWARD].empty() &&
+          queues[FORWARD].top().first + queues[BACKWARD].top().first < distance) {
+        int const side = queues[FORWARD].size() <= queues[BACKWARD].size() ? FORWARD : BACKWARD;
+        CsrGraph<N,E> const& searched = side == FORWARD ? graph : reverse;
+        std::vector<E> const& other = distances[1 - side];
+        int const current = queues[side].pop().second;
+        E const reached = distances[side][current];
+        settled[side][current] = true;
+        numSettled++;
+        GRAPH_STATS_ADD(SETTLED, 1);
+        GRAPH_STATS_ADD(RELAXATIONS, searched.arcsEnd(current) - searched.arcsBegin(current));
+        for (unsigned int arc = searched.arcsBegin(current); arc < searched.arcsEnd(current); arc++)
         {
-            int const targetId = e.getTo();
-            if(!flag.at(targetId) && e.getCost() + min.at(current.getId()) < min.at(targetId)) {
-                min.insert_or_assign(targetId, e.getCost() + min.at(current.getId()));
-                edgesQueue.push(e);
-                prev.insert_or_assign(targetId, e);
+            int const target = searched.getTarget(arc);
+            E const cost = reached + searched.getCost(arc);
+            if(!settled[side][target] && cost < distances[side][target]) {
+                if(predecessors[side][target] == -1 && target != starts[side]) {
+                    touched[side].push_back(target);
+                }
+                distances[side][target] = cost;
+                predecessors[side][target] = current;
+                arcs[side][target] = arc;
+                queues[side].pushOrDecrease(target, cost);
+            }
+            //A path through the arc, joining the two searches
+            if(other[target] != std::numeric_limits<E>().max() && distances[side][target] + other[target] < distance) {
+                distance = distances[side][target] + other[target];
+                meeting = target;
+            }
+        }
+    }
+    return meeting != -1;
+}
+
+//Returns the index of the node where the shortest path found by the last search joins the two searches, -1 if there is none
+template <typename E>
+int BidirectionalWorkspace<E>::getMeetingNode() const {
+    return meeting;
+}
+
+//Returns the cost of the shortest path found by the last search, std::numeric_limits<E>::max() if there is none
+template <typename E>
+E BidirectionalWorkspace<E>::getDistance() const {
+    return distance;
+}
+
+//Returns the number of nodes the last search settled, adding up both directions
+template <typename E>
+unsigned int BidirectionalWorkspace<E>::getNumSettled() const {
+    return numSettled;
+}
+
+//Returns the node preceding the one with the given index in the search of the direction, -1 for its start and unreached nodes
+template <typename E>
+int BidirectionalWorkspace<E>::getPredecessor(SearchDirection const direction, int const index) const {
+    return predecessors[direction][index];
+}
+
+//Returns the arc reaching the node with the given index in the search of the direction, an arc of the reverse graph when BACKWARD
+template <typename E>
+unsigned int BidirectionalWorkspace<E>::getPredecessorArc(SearchDirection const direction, int const index) const {
+    return arcs[direction][index];
+}
+
+/* Computes the shortest path using bidirectional Dijkstra: a forward search from the start and a backward one from
+   the end, meeting halfway, so that long paths settle far fewer nodes than compute_SP_Dijkstra. The path has the same
+   cost, and is the same one when the shortest path is unique
+    Parameters:
+        -graph:     a reference to the frozen graph
+        -reverse:   its transpose, see CsrGraph::reversed, built once for all the queries
+        -fromId:    the id of the starting node
+        -toId:      the id of the end node
+        -workspace: the state reused between searches, which also tells how many nodes were settled
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_Bidirectional_Dijkstra(CsrGraph<N,E> const& graph, CsrGraph<N,E> const& reverse, int const fromId,
+                                                            int const toId, BidirectionalWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SP_Bidirectional_Dijkstra");
+    int const from = graph.getIndex(fromId), to = graph.getIndex(toId);
+    if(!workspace.search(graph, reverse, from, to)) {
+        return {};
+    }
+    int const meeting = workspace.getMeetingNode();
+    std::vector<int> nodes;
+    std::vector<E> costs;
+    std::vector<bool> bidirectional;
+    //From the meeting node back to the start, along the forward tree, then turned around
+    for (int current = meeting; current != from; current = workspace.getPredecessor(FORWARD, current)) {
+        unsigned int const arc = workspace.getPredecessorArc(FORWARD, current);
+        nodes.push_back(graph.getId(current));
+        costs.push_back(graph.getCost(arc));
+        bidirectional.push_back(graph.isBidirectional(arc));
+    }
+    nodes.push_back(fromId);
+    std::reverse(nodes.begin(), nodes.end());
+    std::reverse(costs.begin(), costs.end());
+    std::reverse(bidirectional.begin(), bidirectional.end());
+    //From the meeting node on to the end, along the backward tree
+    for (int current = meeting; current != to; current = workspace.getPredecessor(BACKWARD, current)) {
+        unsigned int const arc = workspace.getPredecessorArc(BACKWARD, current);
+        nodes.push_back(graph.getId(workspace.getPredecessor(BACKWARD, current)));
+        costs.push_back(reverse.getCost(arc));
+        bidirectional.push_back(reverse.isBidirectional(arc));
+    }
+    return Path<E>(std::move(nodes), std::move(costs), std::move(bidirectional));
+}
+
+/* Computes the shortest path using bidirectional Dijkstra, see the workspace overload; for repeated queries build
+   the reverse graph and the workspace once */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_Bidirectional_Dijkstra(CsrGraph<N,E> const& graph, int const fromId, int const toId) {
+    BidirectionalWorkspace<E> workspace;
+    return compute_SP_Bidirectional_Dijkstra(graph, graph.reversed(), fromId, toId, workspace);
+}
+
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_Bidirectional_Dijkstra(Graph<N,E> const& graph, int const fromId, int const toId) {
+    return compute_SP_Bidirectional_Dijkstra(graph.freeze(), fromId, toId);
+}
+
+//Dimension of the geometric kernels when it is only known at run time, from the graph
+constexpr unsigned int DYNAMIC_DIM = 0;
+
+/* Calls body with the dimension of the coordinates as a std::integral_constant: 1, 2 and 3 become compile-time constants,
+   so that the kernels instantiated with them unroll their loops over the dimensions; any other is DYNAMIC_DIM */
+template <typename F>
+decltype(auto) dispatchDimension(unsigned int const dim, F const& body) {
+    switch(dim) {
+        case 1:
+            return body(std::integral_constant<unsigned int, 1>());
+        case 2:
+            return body(std::integral_constant<unsigned int, 2>());
+        case 3:
+            return body(std::integral_constant<unsigned int, 3>());
+        default:
+            return body(std::integral_constant<unsigned int, DYNAMIC_DIM>());
+    }
+}
+
+//Returns the squared straight line distance between two nodes (by index), over D dimensions or the graph's ones if D is DYNAMIC_DIM
+template <unsigned int D, typename N, typename E>
+float squaredDistance(CsrGraph<N,E> const& graph, int const from, int const to) {
+    unsigned int const dim = D == DYNAMIC_DIM ? graph.getDimensions() : D;
+    float sum = 0;
+    for (unsigned int d = 0; d < dim; d++) {
+        float const* const axis = graph.getAxis(d);
+        float const diff = axis[from] - axis[to];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+//Turns a straight line distance into a lower bound of the cost of the paths spanning it, see euclideanBound
+template <typename E>
+E geometricBound(float const squared, float const costPerUnit) {
+    float const bound = std::sqrt(squared) * costPerUnit;
+    if constexpr (std::is_integral_v<E>) {
+        return static_cast<E>(std::floor(bound));
+    } else {
+        return static_cast<E>(bound);
+    }
+}
+
+/* Returns the straight line distance between two nodes (by index) times costPerUnit, rounded down for integral costs.
+   It is a consistent A* potential as long as no edge costs less than costPerUnit times the length of the segment joining its ends */
+template <typename N, typename E>
+E euclideanBound(CsrGraph<N,E> const& graph, int const from, int const to, float const costPerUnit) {
+    return geometricBound<E>(squaredDistance<DYNAMIC_DIM>(graph, from, to), costPerUnit);
+}
+
+/* Computes the shortest path between two nodes using A*, guided by the straight line distance to the end node
+    Parameters:
+        -graph:       a reference to the frozen graph, whose costs must be geometric (see euclideanBound)
+        -fromId:      the id of the starting node
+        -toId:        the id of the end node
+        -workspace:   the state reused between searches, which holds the result
+        -costPerUnit: the smallest cost of a unit of length of an edge
+    Returns: the tree of the settled nodes (by index), valid until the next search with the same workspace */
+template <typename N, typename E>
+ShortestPathTree<E> const& compute_SPT_AStar(CsrGraph<N,E> const& graph, int const fromId, int const toId, DijkstraWorkspace<E>& workspace, float const costPerUnit = 1) {
+    GRAPH_STATS_SCOPE("compute_SPT_AStar");
+    int const to = graph.getIndex(toId);
+    return dispatchDimension(graph.getDimensions(), [&](auto const dim) -> ShortestPathTree<E> const& {
+        return workspace.search(graph, graph.getIndex(fromId), &to, 1, [&graph, to, costPerUnit](int const node) {
+            return geometricBound<E>(squaredDistance<decltype(dim)::value>(graph, node, to), costPerUnit);
+        });
+    });
+}
+
+/* Computes the shortest path between two nodes using A* with the straight line distance, see compute_SPT_AStar
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_AStar(CsrGraph<N,E> const& graph, int const fromId, int const toId, float const costPerUnit = 1) {
+    GRAPH_STATS_SCOPE("compute_SP_AStar");
+    DijkstraWorkspace<E> workspace;
+    return makePath(graph, compute_SPT_AStar(graph, fromId, toId, workspace, costPerUnit), graph.getIndex(toId));
+}
+
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_AStar(Graph<N,E> const& graph, int const fromId, int const toId, float const costPerUnit = 1) {
+    return compute_SP_AStar(graph.freeze(), fromId, toId, costPerUnit);
+}
+
+/* Picks numLandmarks landmarks and computes their distances from (and, with one-way edges, to) every node.
+   Each landmark is the node farthest from the ones already picked, starting from the node farthest from the first one;
+   nodes no landmark reaches are picked first, so that every component gets one. The searches towards the landmarks
+   run on the reversed graph, in parallel
+    Parameters:
+        -graph:        a reference to the frozen graph
+        -numLandmarks: how many landmarks to pick, more give tighter bounds but cost memory and time per node
+        -numThreads:   the number of threads to use, 0 means one per hardware thread
+    Returns: the landmark table, which stays valid as long as the graph does not change */
+template <typename N, typename E>
+LandmarkTable<E> compute_ALT_Landmarks(CsrGraph<N,E> const& graph, int const numLandmarks = 8, unsigned int const numThreads = 0) {
+    GRAPH_STATS_SCOPE("compute_ALT_Landmarks");
+    GRAPH_STATS_PHASE("from landmarks");
+    size_t const n = graph.getNumNodes();
+    size_t const count = std::min<size_t>(numLandmarks, n);
+    E const max = std::numeric_limits<E>().max();
+    bool const symmetric = !myGraphUtils::isDirect(graph);
+    std::vector<int> landmarks;
+    std::vector<E> fromLandmarks(n * count), toLandmarks(symmetric ? 0 : n * count);
+    ScratchVector<E> closest(n, max, myGraphUtils::getScratchResource()); //given a node index, its distance from the nearest landmark
+    DijkstraWorkspace<E> workspace;
+    if(n > 0) {
+        ShortestPathTree<E> const& seed = workspace.search(graph, 0, {});
+        closest.assign(seed.getDistances().begin(), seed.getDistances().end());
+    }
+    for (size_t l = 0; l < count; l++) {
+        int pick = -1;
+        for (size_t i = 0; i < n; i++) {
+            if(closest[i] == max) {
+                pick = i;
+                break;
+            }
+            if(pick == -1 || closest[pick] < closest[i]) {
+                pick = i;
             }
         }
-        flag.at(current.getId()) = true;
+        landmarks.push_back(pick);
+        ShortestPathTree<E> const& tree = workspace.search(graph, pick, {});
+        for (size_t i = 0; i < n; i++) {
+            fromLandmarks[i * count + l] = tree.getDistance(i);
+            closest[i] = l == 0 ? tree.getDistance(i) : std::min(closest[i], tree.getDistance(i));
+        }
+    }
+    if(!symmetric) {
+        GRAPH_STATS_PHASE("to landmarks");
+        CsrGraph<N,E> const reverse = graph.reversed();
+        myGraphUtils::parallelFor(0, count, [&](size_t const l) {
+            DijkstraWorkspace<E> reverseWorkspace;
+            ShortestPathTree<E> const& tree = reverseWorkspace.search(reverse, landmarks[l], {});
+            for (size_t i = 0; i < n; i++) {
+                toLandmarks[i * count + l] = tree.getDistance(i);
+            }
+        }, numThreads);
     }
-    //Building the path
-    do {
-        Edge<E> const& edge = prev.at(current.getId());
-        Node<N,E> const& prevNode = directg.getNode(edge.getFrom());
-        sp.addNode(current);
-        sp.addNode(prevNode);
-        sp.addEdge(edge.getFrom(), edge.getTo(), edge.getCost(), edge.isBidirectional());
-        current = prevNode;
-    } while(current.getId() != fromId);
+    return LandmarkTable<E>(landmarks, std::move(fromLandmarks), std::move(toLandmarks));
+}
 
-    return {sp};
+template <typename N, typename E>
+LandmarkTable<E> compute_ALT_Landmarks(Graph<N,E> const& graph, int const numLandmarks = 8, unsigned int const numThreads = 0) {
+    return compute_ALT_Landmarks(graph.freeze(), numLandmarks, numThreads);
 }
 
+/* Computes the shortest path between two nodes using ALT: A* with the landmark lower bounds as potential
+    Parameters:
+        -graph:     a reference to the frozen graph
+        -landmarks: the landmark table of the same graph (see compute_ALT_Landmarks)
+        -fromId:    the id of the starting node
+        -toId:      the id of the end node
+        -workspace: the state reused between searches, which holds the result
+    Returns: the tree of the settled nodes (by index), valid until the next search with the same workspace */
+template <typename N, typename E>
+ShortestPathTree<E> const& compute_SPT_ALT(CsrGraph<N,E> const& graph, LandmarkTable<E> const& landmarks, int const fromId, int const toId, DijkstraWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SPT_ALT");
+    int const to = graph.getIndex(toId);
+    return workspace.search(graph, graph.getIndex(fromId), &to, 1, [&landmarks, to](int const node) {
+        return landmarks.lowerBound(node, to);
+    });
+}
 
+/* Computes the shortest path between two nodes using ALT, see compute_SPT_ALT
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_ALT(CsrGraph<N,E> const& graph, LandmarkTable<E> const& landmarks, int const fromId, int const toId) {
+    GRAPH_STATS_SCOPE("compute_SP_ALT");
+    DijkstraWorkspace<E> workspace;
+    return makePath(graph, compute_SPT_ALT(graph, landmarks, fromId, toId, workspace), graph.getIndex(toId));
+}
+
+template<typename N, typename E>
+std::optional<PathMatrix<E>> compute_SP_Floyd_Warshall(Graph<N,E> const& graph) {
+    return compute_SP_Floyd_Warshall(graph.freeze());
+}
+
+/* Computes the shortest paths between every pair of nodes using Floyd-Warshall's algorithm on a CSR snapshot of the graph
+    Parameters:
+        -graph: a reference to the frozen graph
+    Returns: an optional containing the distance and next hop matrices if the graph has no negative cycles, otherwise an
+             empty one; PathMatrix::toGraph gives the graph of the first edge of the shortest path between every connected pair */
 template<typename N, typename E>
-std::optional<Graph<N,E>> compute_SP_Floyd_Warshall(Graph<N,E> const& graph) {
-    std::map<std::pair<int,int>, E> min; //given idFrom and idTo (in the pair), returns current minimum path cost to reach it
-    std::map<std::pair<int,int>,Edge<E>> prev; //given node id, returns the id of the preceding node in the path
-    Graph<N,E> const& strippedg = myGraphUtils::stripRedundantEdges(myGraphUtils::makeDirect(graph), true);
-    Graph<N,E> result;
-    //Initialization
-    for (Node<N,E> const& from : strippedg.getNodes())
+std::optional<PathMatrix<E>> compute_SP_Floyd_Warshall(CsrGraph<N,E> const& graph) {
+    GRAPH_STATS_SCOPE("compute_SP_Floyd_Warshall");
+    return compute_APSP_Floyd_Warshall(graph);
+}
+
+#pragma endregion
+
+#pragma region ALL_PAIRS_SHORTEST_PATH
+
+//Side of the square tiles the distance matrix is split into by the blocked Floyd-Warshall:
+//three 64x64 tiles of 4-byte costs fit in the L1 cache of most cores
+constexpr size_t FLOYD_WARSHALL_TILE = 64;
+
+//Distance used for unreachable pairs inside the all-pairs engines: infinity for floating point costs, so that sums
+//stay unreachable, half of the maximum for integral ones, so that adding two of them does not overflow
+template <typename E>
+constexpr E apspInfinity() {
+    if constexpr (std::numeric_limits<E>::has_infinity) {
+        return std::numeric_limits<E>::infinity();
+    } else {
+        return std::numeric_limits<E>::max() / 2;
+    }
+}
+
+/* Runs the iterations kBegin..kEnd of Floyd-Warshall restricted to the tile [rowBegin, rowEnd) x [colBegin, colEnd).
+   The same min-plus update serves the three phases of the blocked algorithm; the inner loop is branch-free over
+   contiguous rows, so the compiler vectorizes it for both integral and floating point costs.
+   With TieBreak, equal distances are compared by number of hops: the blocked order does not relax the tiles in the
+   order of the classic algorithm, so with zero cost cycles the next hops could otherwise point at each other */
+template <typename E, bool TieBreak>
+static void relaxFloydWarshallTile(E* const dist, int* const next, int* const hops, size_t const n, size_t const kBegin, size_t const kEnd,
+                                   size_t const rowBegin, size_t const rowEnd, size_t const colBegin, size_t const colEnd) {
+    E const inf = apspInfinity<E>();
+    for (size_t k = kBegin; k < kEnd; k++)
     {
-        result.addNode(from);
-        std::vector<Edge<E>> const& neighbours = from.getAdjacentEdges();
-        for (Node<N,E> const& to : strippedg.getNodes()) {
-            min.insert_or_assign({from.getId(), to.getId()}, std::numeric_limits<E>().max());
-            Edge<E> e(from.getId(), to.getId(), std::numeric_limits<E>().max(), false);
-            prev.insert_or_assign({e.getFrom(), e.getTo()}, e);
-        }
-        for (Edge<E> const& e : neighbours)
+        E const* __restrict const distK = dist + k * n;
+        int const* __restrict const hopsK = TieBreak ? hops + k * n : nullptr;
+        for (size_t i = rowBegin; i < rowEnd; i++)
         {
-            prev.insert_or_assign({e.getFrom(), e.getTo()}, e);
-            min.insert_or_assign({e.getFrom(), e.getTo()}, e.getCost());
+            E const distIK = dist[i * n + k];
+            //Row k itself can not improve unless there is a negative cycle, which is reported anyway
+            if(i == k || distIK == inf) {
+                continue;
+            }
+            int const nextIK = next[i * n + k];
+            E* __restrict const distI = dist + i * n;
+            int* __restrict const nextI = next + i * n;
+            int* __restrict const hopsI = TieBreak ? hops + i * n : nullptr;
+            int const hopsIK = TieBreak ? hopsI[k] : 0;
+            for (size_t j = colBegin; j < colEnd; j++)
+            {
+                E const alt = distIK + distK[j];
+                bool better = alt < distI[j];
+                if constexpr (TieBreak) {
+                    int const altHops = hopsIK + hopsK[j];
+                    better = better || (alt == distI[j] && altHops < hopsI[j]);
+                    better = better && distK[j] != inf;
+                    hopsI[j] = better ? altHops : hopsI[j];
+                } else if constexpr (!std::numeric_limits<E>::has_infinity) {
+                    //With negative costs, inf + distIK could look reachable
+                    better = better && distK[j] != inf;
+                }
+                distI[j] = better ? alt : distI[j];
+                nextI[j] = better ? nextIK : nextI[j];
+            }
         }
     }
-    for (Node<N,E> const& h : strippedg.getNodes())
+}
+
+/* Computes the shortest paths between every pair of nodes with a blocked, multi-threaded Floyd-Warshall
+   over a flat n x n distance matrix. For each diagonal tile, the tile itself is relaxed first, then the tiles
+   in its row and column, then all the others; the tiles of the last two phases are relaxed in parallel
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: an optional containing the distance and next hop matrices if the graph has no negative cycles,
+             otherwise an empty one */
+template <typename N, typename E>
+std::optional<PathMatrix<E>> compute_APSP_Floyd_Warshall(CsrGraph<N,E> const& graph, unsigned int const numThreads = 0) {
+    GRAPH_STATS_SCOPE("compute_APSP_Floyd_Warshall");
+    GRAPH_STATS_PHASE("init");
+    size_t const n = graph.getNumNodes(), tile = FLOYD_WARSHALL_TILE;
+    size_t const blocks = (n + tile - 1) / tile;
+    E const inf = apspInfinity<E>();
+    std::vector<E> dist(n * n, inf);
+    std::vector<int> next(n * n, -1);
+    //Hop counts are only needed to break ties, which can only create cycles with zero or negative costs
+    bool tieBreak = false;
+    for (unsigned int arc = 0; arc < graph.getNumArcs() && !tieBreak; arc++) {
+        tieBreak = !(graph.getCost(arc) > 0);
+    }
+    ScratchVector<int> hops(tieBreak ? n * n : 0, 0, myGraphUtils::getScratchResource());
+    //Initialization: only the cheapest of the parallel edges is kept
+    for (size_t from = 0; from < n; from++)
     {
-        for (Node<N,E> const& i : strippedg.getNodes())
+        dist[from * n + from] = 0;
+        next[from * n + from] = from;
+        for (unsigned int arc = graph.arcsBegin(from); arc < graph.arcsEnd(from); arc++)
         {
-            for (Node<N,E> const& j : strippedg.getNodes())
-            {
-                E const max = std::numeric_limits<E>().max();
-                E const minIJ = min.at({i.getId(),j.getId()}), minIH = min.at({i.getId(),h.getId()}), minHJ = min.at({h.getId(),j.getId()});
-                E const altMin = minIH == max || minHJ == max ? max : minIH + minHJ;
-                if(minIJ > altMin) {
-                    min.insert_or_assign({i.getId(), j.getId()}, altMin);
-                    prev.insert_or_assign({i.getId(), j.getId()}, prev.at({h.getId(), j.getId()}));
+            size_t const to = graph.getTarget(arc);
+            if(graph.getCost(arc) < dist[from * n + to]) {
+                dist[from * n + to] = graph.getCost(arc);
+                next[from * n + to] = to;
+                if(tieBreak) {
+                    hops[from * n + to] = 1;
                 }
             }
-        }    
+        }
+    }
+    auto relax = [&](size_t const kb, size_t const ib, size_t const jb) {
+        size_t const kBegin = kb * tile, kEnd = std::min(n, (kb + 1) * tile);
+        size_t const rowBegin = ib * tile, rowEnd = std::min(n, (ib + 1) * tile);
+        size_t const colBegin = jb * tile, colEnd = std::min(n, (jb + 1) * tile);
+        if(tieBreak) {
+            relaxFloydWarshallTile<E,true>(dist.data(), next.data(), hops.data(), n, kBegin, kEnd, rowBegin, rowEnd, colBegin, colEnd);
+        } else {
+            relaxFloydWarshallTile<E,false>(dist.data(), next.data(), hops.data(), n, kBegin, kEnd, rowBegin, rowEnd, colBegin, colEnd);
+        }
+    };
+    GRAPH_STATS_PHASE("tiles");
+    GRAPH_STATS_ADD(RELAXATIONS, n * n * n);
+    for (size_t kb = 0; kb < blocks; kb++)
+    {
+        relax(kb, kb, kb);
+        //Tiles in the same row and column of the diagonal one: they only depend on it and on themselves
+        myGraphUtils::parallelFor(0, 2 * (blocks - 1), [&](size_t const t) {
+            size_t const other = t / 2 < kb ? t / 2 : t / 2 + 1;
+            if(t % 2 == 0) {
+                relax(kb, kb, other);
+            } else {
+                relax(kb, other, kb);
+            }
+        }, numThreads);
+        //All the other tiles, which only depend on the ones of the previous phase
+        myGraphUtils::parallelFor(0, (blocks - 1) * (blocks - 1), [&](size_t const t) {
+            size_t const ib = t / (blocks - 1), jb = t % (blocks - 1);
+            relax(kb, ib < kb ? ib : ib + 1, jb < kb ? jb : jb + 1);
+        }, numThreads);
     }
-    for (auto const& pair : prev) {
-        Edge<E> const& e = pair.second;
-        if(e.getCost() < 0) {
+    GRAPH_STATS_PHASE("extract");
+    for (size_t i = 0; i < n; i++) {
+        if(dist[i * n + i] < 0) {
             return {};
         }
-        result.addEdge(e.getFrom(), e.getTo(), e.getCost(), e.isBidirectional());
     }
-    return {result};
+    for (size_t i = 0; i < n * n; i++) {
+        if(next[i] == -1) {
+            dist[i] = std::numeric_limits<E>().max();
+        }
+    }
+    return {PathMatrix<E>(std::vector<int>(graph.getIds().begin(), graph.getIds().end()), std::move(dist), std::move(next))};
+}
+
+/* Computes the shortest paths between every pair of nodes with the blocked Floyd-Warshall, see the CsrGraph overload */
+template <typename N, typename E>
+std::optional<PathMatrix<E>> compute_APSP_Floyd_Warshall(Graph<N,E> const& graph, unsigned int const numThreads = 0) {
+    return compute_APSP_Floyd_Warshall(graph.freeze(), numThreads);
+}
+
+/* Computes feasible potentials for Johnson's reweighting (see CsrGraph::reweighted): the distances of the nodes from a
+   virtual source joined to all of them by zero cost arcs, with a queue based Bellman-Ford (SPFA). Every node starts
+   queued at distance 0 and is queued again when its distance goes down. The number of arcs on the path each distance
+   comes from is tracked: a path with as many arcs as there are nodes goes twice through a node, and since its distance
+   went down in between, the cycle between the two visits is negative
+    Parameters:
+        -graph: a reference to the frozen graph
+    Returns: an optional containing the potential of every node (by index), empty if the graph has a negative cycle */
+template <typename N, typename E>
+std::optional<std::vector<E>> compute_Potentials_Bellman_Ford(CsrGraph<N,E> const& graph) {
+    GRAPH_STATS_SCOPE("compute_Potentials_Bellman_Ford");
+    int const numNodes = graph.getNumNodes();
+    std::vector<E> potentials(numNodes, 0);
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<int> lengths(numNodes, 0, scratch);
+    ScratchVector<bool> queued(numNodes, true, scratch);
+    ScratchVector<int> queue(numNodes, scratch); //circular, a node is never queued twice at once
+    for (int i = 0; i < numNodes; i++) {
+        queue[i] = i;
+    }
+    GRAPH_STATS_ADD(HEAP_PUSHES, numNodes);
+    for (size_t head = 0, count = numNodes; count > 0; head = (head + 1) % numNodes, count--) {
+        int const current = queue[head];
+        queued[current] = false;
+        GRAPH_STATS_ADD(HEAP_POPS, 1);
+        GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(current) - graph.arcsBegin(current));
+        for (unsigned int arc = graph.arcsBegin(current); arc < graph.arcsEnd(current); arc++) {
+            int const target = graph.getTarget(arc);
+            E const candidate = potentials[current] + graph.getCost(arc);
+            if(candidate < potentials[target]) {
+                potentials[target] = candidate;
+                lengths[target] = lengths[current] + 1;
+                if(lengths[target] >= numNodes) {
+                    return {};
+                }
+                if(!queued[target]) {
+                    queued[target] = true;
+                    queue[(head + count) % numNodes] = target;
+                    count++;
+                    GRAPH_STATS_ADD(HEAP_PUSHES, 1);
+                }
+            }
+        }
+    }
+    return potentials;
+}
 
+/* Computes the shortest paths from every node with Johnson's algorithm and hands them over one source at a time, so
+   that they never have to be held all at once. The costs are first made non negative by reweighting the graph with
+   the potentials of compute_Potentials_Bellman_Ford (skipped when no cost is negative), then one Dijkstra search runs
+   from each source, the sources being spread over the threads, each with its own workspace
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -visit:      called as visit(source, distances, predecessors) for every source index, concurrently from the worker
+                     threads: the distance of every node from the source (std::numeric_limits<E>::max() if unreachable)
+                     and its predecessor index (-1 for the source and unreachable nodes), only valid during the call
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: false if the graph has a negative cycle, without calling visit */
+template <typename N, typename E, typename V>
+bool compute_APSP_Johnson_Stream(CsrGraph<N,E> const& graph, V const& visit, unsigned int const numThreads = 0) {
+    GRAPH_STATS_SCOPE("compute_APSP_Johnson");
+    int const numNodes = graph.getNumNodes();
+    E const max = std::numeric_limits<E>().max();
+    bool const negative = graph.getMinCost() < 0;
+    GRAPH_STATS_PHASE("reweighting");
+    std::vector<E> potentials(numNodes, 0);
+    CsrGraph<N,E> reweighted;
+    if(negative) {
+        std::optional<std::vector<E>> feasible = compute_Potentials_Bellman_Ford(graph);
+        if(!feasible) {
+            return false;
+        }
+        potentials = std::move(feasible.value());
+        reweighted = graph.reweighted(potentials);
+    }
+    CsrGraph<N,E> const& searched = negative ? reweighted : graph;
+    GRAPH_STATS_PHASE("searches");
+    std::vector<int> const noTargets;
+    myGraphUtils::parallelForWithState(0, numNodes, []() {
+        return std::pair<DijkstraWorkspace<E>, std::vector<E>>();
+    }, [&](std::pair<DijkstraWorkspace<E>, std::vector<E>>& state, size_t const source) {
+        auto& [workspace, distances] = state;
+        ShortestPathTree<E> const& tree = workspace.search(searched, source, noTargets);
+        //Undoing the reweighting: a path from s to t got potentials[s] - potentials[t] added to its cost
+        distances.resize(numNodes);
+        for (int i = 0; i < numNodes; i++) {
+            E const distance = tree.getDistance(i);
+            distances[i] = distance == max ? max : distance - potentials[source] + potentials[i];
+        }
+        visit((int)source, distances, tree.getPredecessors());
+    }, numThreads);
+    return true;
+}
+
+/* Computes the shortest paths between every pair of nodes with Johnson's algorithm (see compute_APSP_Johnson_Stream):
+   on sparse graphs it takes O(n m log n) instead of the O(n^3) of Floyd-Warshall, but the result still takes n^2 space
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: an optional containing the distance and next hop matrices if the graph has no negative cycles,
+             otherwise an empty one */
+template <typename N, typename E>
+std::optional<PathMatrix<E>> compute_APSP_Johnson(CsrGraph<N,E> const& graph, unsigned int const numThreads = 0) {
+    size_t const n = graph.getNumNodes();
+    std::vector<E> dist(n * n);
+    std::vector<int> next(n * n, -1);
+    bool const feasible = compute_APSP_Johnson_Stream(graph, [&](int const source, std::vector<E> const& distances, std::vector<int> const& predecessors) {
+        std::copy(distances.begin(), distances.end(), dist.begin() + source * n);
+        //The next hop of a node is the one of its predecessor, or the node itself if the predecessor is the source
+        int* const hops = next.data() + source * n;
+        hops[source] = source;
+        std::vector<int> chain;
+        for (size_t i = 0; i < n; i++) {
+            int current = i;
+            while(hops[current] == -1 && predecessors[current] != -1 && predecessors[current] != source) {
+                chain.push_back(current);
+                current = predecessors[current];
+            }
+            if(hops[current] == -1 && predecessors[current] == source) {
+                hops[current] = current;
+            }
+            for (int const node : chain) {
+                hops[node] = hops[current];
+            }
+            chain.clear();
+        }
+    }, numThreads);
+    if(!feasible) {
+        return {};
+    }
+    return {PathMatrix<E>(std::vector<int>(graph.getIds().begin(), graph.getIds().end()), std::move(dist), std::move(next))};
+}
+
+/* Computes the shortest paths between every pair of nodes with Johnson's algorithm, see the CsrGraph overload */
+template <typename N, typename E>
+std::optional<PathMatrix<E>> compute_APSP_Johnson(Graph<N,E> const& graph, unsigned int const numThreads = 0) {
+    return compute_APSP_Johnson(graph.freeze(), numThreads);
+}
+
+#pragma endregion
+
+#pragma region TRAVERSAL
+
+//compute_BFS goes bottom up once the arcs leaving the frontier are more than the unexplored ones over BFS_ALPHA,
+//and back top down once the frontier stops growing and holds fewer than the nodes over BFS_BETA
+constexpr int BFS_ALPHA = 15;
+constexpr int BFS_BETA = 18;
+//Nodes per chunk of a bottom up step, a multiple of 64 so that every chunk owns whole words of the frontier bitmap
+constexpr size_t BFS_GRAIN = 4096;
+
+/* Computes the breadth first tree of a node with a direction-optimizing search. While the frontier is small, each of
+   its nodes claims its unvisited neighbours (top down); once the arcs leaving it outnumber a share of the unexplored
+   ones, every unvisited node looks instead among its in-neighbours for one in the frontier, kept as a bitmap, and stops
+   at the first (bottom up), which skips most of the arcs on the few large middle levels.
+   Both steps run in parallel over chunks of nodes. The levels are the ones a queue based search finds, the parent of a
+   node is any of its in-neighbours on the level before
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -reverse:    the graph with its arcs reversed (see CsrGraph::reversed), or the graph itself if it has no one-way edges
+        -fromId:     the id of the starting node
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: the level and parent of every node (by index) */
+template <typename N, typename E>
+BreadthFirstTree compute_BFS(CsrGraph<N,E> const& graph, CsrGraph<N,E> const& reverse, int const fromId, unsigned int const numThreads = 0) {
+    GRAPH_STATS_SCOPE("compute_BFS");
+    int const numNodes = graph.getNumNodes();
+    int const from = graph.getIndex(fromId);
+    if(reverse.getNumNodes() != numNodes || reverse.getNumArcs() != graph.getNumArcs()) {
+        throw std::invalid_argument("the reverse graph does not match the graph");
+    }
+    auto degree = [&graph](int const node) -> long long { return graph.arcsEnd(node) - graph.arcsBegin(node); };
+    size_t const numWords = (numNodes + 63) / 64;
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<std::atomic<int>> parents(numNodes, scratch); //-1 until the node is claimed
+    for (std::atomic<int>& p : parents) {
+        p.store(-1, std::memory_order_relaxed);
+    }
+    std::vector<int> levels(numNodes, -1);
+    ScratchVector<uint64_t> current(numWords, 0, scratch), next(numWords, 0, scratch);
+    ScratchVector<int> frontier(scratch);
+    size_t const grain = 1024;
+    std::vector<std::vector<int>> reached; //per chunk of the frontier, the nodes it claimed (filled by the workers, so not scratch)
+    std::atomic<size_t> claimed(0);        //the nodes claimed by the last step
+    std::atomic<long long> claimedArcs(0); //and the arcs leaving them
+    //Every node of the frontier claims its unvisited neighbours
+    auto topDownStep = [&](int const level) {
+        reached.resize((frontier.size() + grain - 1) / grain);
+        myGraphUtils::parallelForChunks(0, frontier.size(), [&](size_t const begin, size_t const end) {
+            std::vector<int>& out = reached[begin / grain];
+            out.clear();
+            long long arcs = 0;
+            for (size_t i = begin; i < end; i++) {
+                int const node = frontier[i];
+                GRAPH_STATS_ADD(RELAXATIONS, degree(node));
+                for (unsigned int arc = graph.arcsBegin(node); arc < graph.arcsEnd(node); arc++) {
+                    int const target = graph.getTarget(arc);
+                    int expected = -1;
+                    if(parents[target].load(std::memory_order_relaxed) == -1 &&
+                       parents[target].compare_exchange_strong(expected, node, std::memory_order_relaxed)) {
+                        levels[target] = level;
+                        out.push_back(target);
+                        arcs += degree(target);
+                    }
+                }
+            }
+            claimedArcs += arcs;
+        }, numThreads, grain);
+        frontier.clear();
+        for (std::vector<int> const& out : reached) {
+            frontier.insert(frontier.end(), out.begin(), out.end());
+        }
+        claimed = frontier.size();
+    };
+    //Every unvisited node looks for an in-neighbour in the frontier bitmap: a node is only written by the chunk holding it
+    auto bottomUpStep = [&](int const level) {
+        std::fill(next.begin(), next.end(), 0);
+        myGraphUtils::parallelForChunks(0, numNodes, [&](size_t const begin, size_t const end) {
+            size_t found = 0;
+            long long arcs = 0, scanned = 0;
+            for (size_t node = begin; node < end; node++) {
+                if(parents[node].load(std::memory_order_relaxed) != -1) {
+                    continue;
+                }
+                for (unsigned int arc = reverse.arcsBegin(node); arc < reverse.arcsEnd(node); arc++) {
+                    int const source = reverse.getTarget(arc);
+                    scanned++;
+                    if((current[source >> 6] >> (source & 63)) & 1) {
+                        parents[node].store(source, std::memory_order_relaxed);
+                        levels[node] = level;
+                        next[node >> 6] |= uint64_t(1) << (node & 63);
+                        found++;
+                        arcs += degree(node);
+                        break;
+                    }
+                }
+            }
+            GRAPH_STATS_ADD(RELAXATIONS, scanned);
+            claimed += found;
+            claimedArcs += arcs;
+        }, numThreads, BFS_GRAIN);
+        current.swap(next);
+    };
+    parents[from].store(from, std::memory_order_relaxed); //Marks the source as visited, its parent is reset at the end
+    levels[from] = 0;
+    frontier.push_back(from);
+    GRAPH_STATS_ADD(SETTLED, 1);
+    long long scout = degree(from); //the arcs leaving the frontier
+    long long unexplored = graph.getNumArcs() - scout; //the arcs leaving the unvisited nodes
+    int level = 0;
+    while(!frontier.empty()) {
+        if(scout > unexplored / BFS_ALPHA) {
+            std::fill(current.begin(), current.end(), 0);
+            for (int const node : frontier) {
+                current[node >> 6] |= uint64_t(1) << (node & 63);
+            }
+            size_t awake = frontier.size(), previous;
+            do {
+                previous = awake;
+                claimed = 0;
+                claimedArcs = 0;
+                bottomUpStep(++level);
+                awake = claimed;
+                scout = claimedArcs;
+                unexplored -= scout;
+                GRAPH_STATS_ADD(SETTLED, awake);
+            } while(awake > 0 && (awake >= previous || awake > (size_t)numNodes / BFS_BETA));
+            //Back to a queue: the last level claimed is the new frontier, empty if the search is over
+            frontier.clear();
+            for (size_t word = 0; word < numWords; word++) {
+                for (uint64_t bits = current[word]; bits != 0; bits &= bits - 1) {
+                    frontier.push_back(word * 64 + __builtin_ctzll(bits));
+                }
+            }
+        } else {
+            claimed = 0;
+            claimedArcs = 0;
+            topDownStep(++level);
+            scout = claimedArcs;
+            unexplored -= scout;
+            GRAPH_STATS_ADD(SETTLED, claimed);
+        }
+    }
+    std::vector<int> result(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+        result[i] = parents[i].load(std::memory_order_relaxed);
+    }
+    result[from] = -1;
+    return BreadthFirstTree(from, std::move(levels), std::move(result));
+}
+
+/* Computes the breadth first tree of a node with a direction-optimizing search, see the overload taking the reverse
+   graph; for repeated searches on a graph with one-way edges build the reverse graph once */
+template <typename N, typename E>
+BreadthFirstTree compute_BFS(CsrGraph<N,E> const& graph, int const fromId, unsigned int const numThreads = 0) {
+    if(graph.getNumDirectedEdges() == 0) {
+        return compute_BFS(graph, graph, fromId, numThreads);
+    }
+    return compute_BFS(graph, graph.reversed(), fromId, numThreads);
+}
+
+template <typename N, typename E>
+BreadthFirstTree compute_BFS(Graph<N,E> const& graph, int const fromId, unsigned int const numThreads = 0) {
+    return compute_BFS(graph.freeze(), fromId, numThreads);
+}
+
+//Number of arcs of every node compute_Components links before guessing the largest component
+constexpr unsigned int AFFOREST_ROUNDS = 2;
+//Number of nodes compute_Components samples to guess the largest component
+constexpr int AFFOREST_SAMPLES = 1024;
+
+/* Joins the trees of two nodes in a forest of components, hooking the root with the higher index under the lower one,
+   so that a parent never has a higher index than its child. It can be called concurrently on the same forest */
+inline void linkComponents(int const u, int const v, ScratchVector<std::atomic<int>>& parents) {
+    int p1 = parents[u].load(std::memory_order_relaxed);
+    int p2 = parents[v].load(std::memory_order_relaxed);
+    while(p1 != p2) {
+        int const high = std::max(p1, p2);
+        int const low = std::min(p1, p2);
+        int parentHigh = parents[high].load(std::memory_order_relaxed);
+        //Either high was already hooked under low, or it is still a root and gets hooked now
+        if(parentHigh == low || (parentHigh == high && parents[high].compare_exchange_strong(parentHigh, low, std::memory_order_relaxed))) {
+            break;
+        }
+        p1 = parents[parents[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+        p2 = parents[low].load(std::memory_order_relaxed);
+    }
+}
+
+//Points every node of a forest of components straight at its root
+inline void compressComponents(ScratchVector<std::atomic<int>>& parents, unsigned int const numThreads) {
+    myGraphUtils::parallelForChunks(0, parents.size(), [&](size_t const begin, size_t const end) {
+        for (size_t node = begin; node < end; node++) {
+            int root = parents[node].load(std::memory_order_relaxed);
+            while(root != parents[root].load(std::memory_order_relaxed)) {
+                root = parents[root].load(std::memory_order_relaxed);
+            }
+            parents[node].store(root, std::memory_order_relaxed);
+        }
+    }, numThreads);
+}
+
+/* Labels the connected components of a graph (the weak ones, if it has one-way edges) with Afforest: the nodes are
+   joined in a forest as their arcs are linked concurrently, the first AFFOREST_ROUNDS arcs of every node first. That is
+   usually enough for most of the graph to end up in one tree, which a sample of the nodes finds: its nodes then skip the
+   rest of their arcs, as the other end of each one links it from its own side. With one-way edges there is no other
+   side, so no node skips its arcs
+    Parameters:
+        -graph:      a reference to the frozen graph
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+    Returns: the component of every node (by index) */
+template <typename N, typename E>
+ComponentLabels compute_Components(CsrGraph<N,E> const& graph, unsigned int const numThreads = 0) {
+    GRAPH_STATS_SCOPE("compute_Components");
+    int const numNodes = graph.getNumNodes();
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<std::atomic<int>> parents(numNodes, scratch);
+    for (int i = 0; i < numNodes; i++) {
+        parents[i].store(i, std::memory_order_relaxed);
+    }
+    GRAPH_STATS_PHASE("rounds");
+    for (unsigned int round = 0; round < AFFOREST_ROUNDS; round++) {
+        myGraphUtils::parallelForChunks(0, numNodes, [&](size_t const begin, size_t const end) {
+            for (size_t node = begin; node < end; node++) {
+                unsigned int const arc = graph.arcsBegin(node) + round;
+                if(arc < graph.arcsEnd(node)) {
+                    linkComponents(node, graph.getTarget(arc), parents);
+                }
+            }
+        }, numThreads);
+        compressComponents(parents, numThreads);
+    }
+    //The most frequent root among evenly spread nodes
+    int largest = -1;
+    if(graph.getNumDirectedEdges() == 0 && numNodes > 0) {
+        ScratchVector<int> roots(scratch);
+        for (long long s = 0; s < AFFOREST_SAMPLES; s++) {
+            roots.push_back(parents[s * numNodes / AFFOREST_SAMPLES].load(std::memory_order_relaxed));
+        }
+        std::sort(roots.begin(), roots.end());
+        size_t best = 0;
+        for (size_t i = 0, j = 0; i < roots.size(); i = j) {
+            for (j = i; j < roots.size() && roots[j] == roots[i]; j++) {}
+            if(j - i > best) {
+                best = j - i;
+                largest = roots[i];
+            }
+        }
+    }
+    GRAPH_STATS_PHASE("linking");
+    myGraphUtils::parallelForChunks(0, numNodes, [&](size_t const begin, size_t const end) {
+        for (size_t node = begin; node < end; node++) {
+            if(parents[node].load(std::memory_order_relaxed) == largest) {
+                continue;
+            }
+            GRAPH_STATS_ADD(RELAXATIONS, graph.arcsEnd(node) - std::min(graph.arcsEnd(node), graph.arcsBegin(node) + AFFOREST_ROUNDS));
+            for (unsigned int arc = graph.arcsBegin(node) + AFFOREST_ROUNDS; arc < graph.arcsEnd(node); arc++) {
+                linkComponents(node, graph.getTarget(arc), parents);
+            }
+        }
+    }, numThreads);
+    compressComponents(parents, numThreads);
+    //A root has the lowest index of its tree, so it is labelled before the rest of it
+    GRAPH_STATS_PHASE("labels");
+    std::vector<int> labels(numNodes);
+    int numComponents = 0;
+    for (int i = 0; i < numNodes; i++) {
+        int const root = parents[i].load(std::memory_order_relaxed);
+        labels[i] = root == i ? numComponents++ : labels[root];
+    }
+    return ComponentLabels(std::move(labels), numComponents);
+}
+
+template <typename N, typename E>
+ComponentLabels compute_Components(Graph<N,E> const& graph, unsigned int const numThreads = 0) {
+    return compute_Components(graph.freeze(), numThreads);
+}
+
+#pragma endregion
+
+#pragma region SPATIAL
+
+//Number of nodes whose distances compute_Nearest_Node computes at once, before looking for the smallest
+constexpr int NEAREST_NODE_BLOCK = 1024;
+
+/* Finds the node closest (in straight line) to a point, scanning the coordinate arrays of the snapshot: the distances of
+   a block of nodes are computed first, in a loop over contiguous arrays the compiler vectorizes, then searched for the smallest
+    Parameters:
+        -graph: a reference to the frozen graph
+        -point: the coordinates of the point, as many as the dimensions of the graph (std::invalid_argument is thrown otherwise)
+    Returns: an optional containing the id of the nearest node (the first one by index among equally near ones), empty if the graph has no nodes */
+template <typename N, typename E>
+std::optional<int> compute_Nearest_Node(CsrGraph<N,E> const& graph, std::vector<float> const& point) {
+    if(point.size() != graph.getDimensions()) {
+        throw std::invalid_argument("the point does not have the dimensions of the graph");
+    }
+    int const n = graph.getNumNodes();
+    if(n == 0) {
+        return {};
+    }
+    return dispatchDimension(graph.getDimensions(), [&](auto const dimension) -> std::optional<int> {
+        constexpr unsigned int D = decltype(dimension)::value;
+        unsigned int const dim = D == DYNAMIC_DIM ? graph.getDimensions() : D;
+        float distances[NEAREST_NODE_BLOCK];
+        float bestDistance = std::numeric_limits<float>::infinity();
+        int best = 0;
+        for (int begin = 0; begin < n; begin += NEAREST_NODE_BLOCK) {
+            int const size = std::min(NEAREST_NODE_BLOCK, n - begin);
+            std::fill(distances, distances + size, 0.0f);
+            for (unsigned int d = 0; d < dim; d++) {
+                float const* __restrict const axis = graph.getAxis(d) + begin;
+                float const coord = point[d];
+                for (int i = 0; i < size; i++) {
+                    float const diff = axis[i] - coord;
+                    distances[i] += diff * diff;
+                }
+            }
+            for (int i = 0; i < size; i++) {
+                if(distances[i] < bestDistance) {
+                    bestDistance = distances[i];
+                    best = begin + i;
+                }
+            }
+        }
+        return graph.getId(best);
+    });
+}
+
+template <typename N, typename E>
+std::optional<int> compute_Nearest_Node(Graph<N,E> const& graph, std::vector<float> const& point) {
+    return compute_Nearest_Node(graph.freeze(), point);
 }
 
 #pragma endregion
@@ -2,14 +2,30 @@
 #define GRAPH_BUILDER
 
 #include "graph_struct.hh"
+#include "graph_utils_parallel.hh"
 #include <random>
 #include <optional>
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
 
 enum DirectMode {ALLDIRECT, ALLBIDIRECTIONAL, MIXED};
 
+/* How the edges are laid out:
+    -ERDOS_RENYI: numEdges edges between uniformly random pairs of nodes
+    -RMAT:        numEdges edges picked by recursively splitting the adjacency matrix in quadrants with probabilities
+                  a, b, c and 1 - a - b - c (R-MAT, a Kronecker graph), giving skewed, power-law like degrees
+    -GRID:        a square-ish grid, every node joined to its right and lower neighbours (numEdges is ignored)
+    -GEOMETRIC:   nodes scattered in the plane, joined when closer than the radius giving about numEdges edges */
+enum GraphModel {ERDOS_RENYI, RMAT, GRID, GEOMETRIC};
+
+//Nodes and edges are generated in blocks of this size, each with its own random stream
+constexpr size_t BUILDER_BLOCK = 1 << 16;
+
 template <typename N, typename E>
 class GraphBuilder {
     private:
@@ -18,7 +34,21 @@ class GraphBuilder {
         N maxNodeWeight = 100, minNodeWeight = 0;
         DirectMode directMode = ALLBIDIRECTIONAL;
         unsigned int numNodes = 10, numEdges = 15;
-        void writeToFile(Graph<N,E> const& graph) const;
+        GraphModel model = ERDOS_RENYI;
+        double rmatA = 0.57, rmatB = 0.19, rmatC = 0.19;
+        uint64_t seed = 5489;
+        unsigned int numThreads = 0;
+        std::string outputFile;
+        //Phases of the generation, so that each one draws from different streams
+        enum Phase : uint64_t {NODES, PATH, EDGES};
+        std::mt19937_64 makeGenerator(Phase const phase, uint64_t const block) const;
+        Edge<E> makeEdge(int const from, int const to, std::mt19937_64& gen) const;
+        unsigned int minConnectedEdges() const;
+        std::vector<Node<N,E>> buildNodes() const;
+        std::vector<Edge<E>> buildRandomEdges() const;
+        std::vector<Edge<E>> buildGridEdges() const;
+        std::vector<Edge<E>> buildGeometricEdges(std::vector<Node<N,E>> const& nodes) const;
+        bool writeToFile(std::vector<Node<N,E>> const& nodes, std::vector<Edge<E>> const& edges) const;
     public:
         GraphBuilder() = default;
         GraphBuilder & setNumNodes(const unsigned int value);
@@ -30,97 +60,300 @@ class GraphBuilder {
         GraphBuilder & setDirect(const DirectMode value);
         GraphBuilder & setNodeWeightLimits(const N min, const N max);
         GraphBuilder & setEdgeWeightLimits(const E min, const E max);
+        GraphBuilder & setModel(const GraphModel value);
+        GraphBuilder & setRmatProbabilities(const double a, const double b, const double c);
+        GraphBuilder & setSeed(const uint64_t value);
+        GraphBuilder & setNumThreads(const unsigned int value);
+        GraphBuilder & setOutputFile(std::string const& filename);
         std::optional<Graph<N,E>> build();
 };
 
+/* Writes the graph in the text format of graph_schema.txt, formatting the numbers with std::to_chars into a buffer
+   that is flushed whenever it fills up
+    Returns: whether the file could be written */
 template <typename N,typename E>
-void GraphBuilder<N,E>::writeToFile(Graph<N,E> const& graph) const {
-    std::string line;
-    std::ofstream file("last.graph");
-    //TODO: remove hardcoded dimensions
-    file << "2 " << numNodes << " " << numEdges << std::endl;
-    for (Node<N,E> const& node : graph.getNodes())
-    {
-        file << node.getId() << " ";
-        for (auto &&i : node.getCoords())
-        {
-            file << i << " ";
+bool GraphBuilder<N,E>::writeToFile(std::vector<Node<N,E>> const& nodes, std::vector<Edge<E>> const& edges) const {
+    std::ofstream file(outputFile, std::ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    size_t used = 0;
+    auto put = [&](auto const value, char const separator) {
+        //Room for the longest number and the separator
+        if(buffer.size() - used < 64) {
+            file.write(buffer.data(), used);
+            used = 0;
         }
-        file << " " << node.getCost() << std::endl;
+        used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+        buffer[used++] = separator;
+    };
+    put(2, ' ');
+    put(nodes.size(), ' ');
+    put(edges.size(), '\n');
+    for (Node<N,E> const& node : nodes) {
+        put(node.getId(), ' ');
+        for (float const c : node.getCoords()) {
+            put(c, ' ');
+        }
+        put(node.getCost(), '\n');
     }
-    for (auto &&i : graph.getEdges())
-    {
-        file << i.getFrom() << " " << i.getTo() << " " << i.getCost() << " " << i.isBidirectional() << std::endl;
+    for (Edge<E> const& edge : edges) {
+        put(edge.getFrom(), ' ');
+        put(edge.getTo(), ' ');
+        put(edge.getCost(), ' ');
+        put((int)edge.isBidirectional(), '\n');
     }
-    file.close();
+    file.write(buffer.data(), used);
+    return file.good();
 }
 
+//Uniform value in [minWeigth, maxWeigth]
 template <typename C>
-C const getRandomCost(C const minWeigth, C const maxWeigth) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    C cost;
-    if( std::is_same_v<C, int>) {
-        std::uniform_int_distribution<int> costGen(minWeigth, maxWeigth);
-        cost = costGen(gen);
+C const getRandomCost(std::mt19937_64& gen, C const minWeigth, C const maxWeigth) {
+    if constexpr (std::is_integral_v<C>) {
+        return std::uniform_int_distribution<C>(minWeigth, maxWeigth)(gen);
     } else {
-        std::uniform_real_distribution<float> costGen(minWeigth, maxWeigth);
-        cost = costGen(gen);
+        return std::uniform_real_distribution<C>(minWeigth, maxWeigth)(gen);
     }
-    //TODO: implement bidirectional, currently hardcoded to true
-    return cost;
 }
 
+/* Random stream of the given block of a phase: its seed mixes the builder seed, the phase and the block (splitmix64),
+   so the graph only depends on the seed, not on the number of threads */
 template <typename N, typename E>
-std::optional<Graph<N,E>> GraphBuilder<N,E>::build() {
-    //Do a random walk generating a node each step, then add random remaining edges
-    Graph<N,E> graph;
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> connect(0.0, 1.0);
-    std::uniform_real_distribution<float> coords(-100, 101);
-    
-    if(this->connected && (this->numEdges < this->numNodes - 1)) {
-        return {};
+std::mt19937_64 GraphBuilder<N,E>::makeGenerator(Phase const phase, uint64_t const block) const {
+    uint64_t z = seed + (phase * BUILDER_BLOCK + block + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return std::mt19937_64(z ^ (z >> 31));
+}
+
+template <typename N, typename E>
+Edge<E> GraphBuilder<N,E>::makeEdge(int const from, int const to, std::mt19937_64& gen) const {
+    E const cost = this->weightedEdges ? getRandomCost<E>(gen, this->minEdgeWeight, this->maxEdgeWeight) : 1;
+    bool const bidirectional = this->directMode == ALLBIDIRECTIONAL || (this->directMode == MIXED && (gen() & 1));
+    return Edge<E>(from, to, cost, bidirectional);
+}
+
+//Number of edges the walk making ERDOS_RENYI and RMAT graphs connected takes: a cycle unless every edge is bidirectional
+template <typename N, typename E>
+unsigned int GraphBuilder<N,E>::minConnectedEdges() const {
+    if(this->numNodes <= 1) {
+        return 0;
     }
-    for (int i = 0; i < this->numNodes;)
-    {
-        //NOTE: as of now, we are hardcoded to two dimensions and costs are ignored
-        Node<N,E> n(i, {coords(gen), coords(gen)}, 0);
-        if(graph.addNode(n)) {
-            i++;
+    return this->directMode == ALLBIDIRECTIONAL ? this->numNodes - 1 : this->numNodes;
+}
+
+//Nodes 0..numNodes-1, scattered in [-100, 101) x [-100, 101), or laid on the grid for GRID
+template <typename N, typename E>
+std::vector<Node<N,E>> GraphBuilder<N,E>::buildNodes() const {
+    std::vector<Node<N,E>> nodes(this->numNodes);
+    unsigned int const width = std::ceil(std::sqrt((double)this->numNodes));
+    myGraphUtils::parallelForChunks(0, this->numNodes, [&](size_t const b, size_t const e) {
+        std::mt19937_64 gen = makeGenerator(NODES, b / BUILDER_BLOCK);
+        std::uniform_real_distribution<float> coords(-100, 101);
+        for (size_t i = b; i < e; i++) {
+            N const cost = this->weightedNodes ? getRandomCost<N>(gen, this->minNodeWeight, this->maxNodeWeight) : 0;
+            if(this->model == GRID) {
+                nodes[i] = Node<N,E>(i, {(float)(i % width), (float)(i / width)}, cost);
+            } else {
+                float const x = coords(gen);
+                nodes[i] = Node<N,E>(i, {x, coords(gen)}, cost);
+            }
         }
+    }, this->numThreads, BUILDER_BLOCK);
+    return nodes;
+}
+
+/* ERDOS_RENYI and RMAT edges. For connected graphs the first edges join the nodes in a random order (a random walk
+   visiting every node), the others are drawn from the model. With one-way edges the walk goes back to its first node,
+   numNodes edges instead of numNodes - 1, so that it is a cycle and every node can still reach every other one */
+template <typename N, typename E>
+std::vector<Edge<E>> GraphBuilder<N,E>::buildRandomEdges() const {
+    std::vector<Edge<E>> edges(this->numEdges);
+    size_t path = 0;
+    if(this->connected && this->numNodes > 1) {
+        std::vector<int> order(this->numNodes);
+        for (unsigned int i = 0; i < this->numNodes; i++) {
+            order[i] = i;
+        }
+        std::mt19937_64 gen = makeGenerator(PATH, 0);
+        std::shuffle(order.begin(), order.end(), gen);
+        path = minConnectedEdges();
+        myGraphUtils::parallelForChunks(0, path, [&](size_t const b, size_t const e) {
+            std::mt19937_64 gen = makeGenerator(PATH, b / BUILDER_BLOCK + 1);
+            for (size_t i = b; i < e; i++) {
+                edges[i] = makeEdge(order[i], order[(i + 1) % this->numNodes], gen);
+            }
+        }, this->numThreads, BUILDER_BLOCK);
+    }
+    int scale = 0;
+    while((1ULL << scale) < this->numNodes) {
+        scale++;
     }
-    //For connected graphs. For unconnected\random ones, just connect random nodes
-    if(this->connected) {
-        std::vector<int> unvisitedNodes;
-        for (size_t i = 0; i < numNodes; i++)
-        {
-            unvisitedNodes.push_back(i);
+    myGraphUtils::parallelForChunks(path, this->numEdges, [&](size_t const b, size_t const e) {
+        std::mt19937_64 gen = makeGenerator(EDGES, (b - path) / BUILDER_BLOCK);
+        std::uniform_int_distribution<int> uniform(0, this->numNodes - 1);
+        //R-MAT: one quadrant per level picks one bit of the source and one of the target; ids past the last node are drawn again.
+        //The quadrant comes from comparing a raw 64 bit draw with the cumulated probabilities scaled to 2^64
+        auto threshold = [](double const p) {
+            return p >= 1 ? UINT64_MAX : p <= 0 ? 0 : (uint64_t)std::ldexp(p, 64);
+        };
+        uint64_t const a = threshold(this->rmatA), ab = threshold(this->rmatA + this->rmatB);
+        uint64_t const abc = threshold(this->rmatA + this->rmatB + this->rmatC);
+        auto rmatEdge = [&]() {
+            while(true) {
+                uint64_t from = 0, to = 0;
+                for (int level = 0; level < scale; level++) {
+                    uint64_t const r = gen();
+                    from = (from << 1) | (r >= ab);
+                    to = (to << 1) | ((r >= a && r < ab) || r >= abc);
+                }
+                if(from < this->numNodes && to < this->numNodes) {
+                    return std::make_pair((int)from, (int)to);
+                }
+            }
+        };
+        for (size_t i = b; i < e; i++) {
+            std::pair<int,int> ends;
+            do {
+                ends = this->model == RMAT ? rmatEdge() : std::make_pair(uniform(gen), uniform(gen));
+            } while(ends.first == ends.second && this->numNodes > 1);
+            edges[i] = makeEdge(ends.first, ends.second, gen);
+        }
+    }, this->numThreads, BUILDER_BLOCK);
+    return edges;
+}
+
+template <typename N, typename E>
+std::vector<Edge<E>> GraphBuilder<N,E>::buildGridEdges() const {
+    unsigned int const n = this->numNodes;
+    unsigned int const width = std::ceil(std::sqrt((double)n));
+    //Edges of node i: to i + 1 if on the same row, to i + width if it exists
+    auto degree = [&](size_t const i) {
+        return (i % width + 1 < width && i + 1 < n) + (i + width < n);
+    };
+    size_t const numBlocks = (n + BUILDER_BLOCK - 1) / BUILDER_BLOCK;
+    std::vector<size_t> offsets(numBlocks + 1, 0);
+    myGraphUtils::parallelFor(0, numBlocks, [&](size_t const block) {
+        for (size_t i = block * BUILDER_BLOCK; i < std::min<size_t>(n, (block + 1) * BUILDER_BLOCK); i++) {
+            offsets[block + 1] += degree(i);
         }
-        
-        int currentId = unvisitedNodes.at(0);
-        unvisitedNodes.erase(unvisitedNodes.begin());
-        while(!unvisitedNodes.empty()) {
-            std::uniform_int_distribution<int> offsetGen(0, unvisitedNodes.size() - 1);
-            int offset = offsetGen(gen);
-            int targetId = unvisitedNodes.at(offset);
-            //TODO:implement cost and bidir
-            graph.addEdge(currentId, targetId, getRandomCost<E>(this->minEdgeWeight, this->maxEdgeWeight), true); 
-            currentId = targetId;
-            unvisitedNodes.erase(unvisitedNodes.begin() + offset);
+    }, this->numThreads);
+    for (size_t block = 0; block < numBlocks; block++) {
+        offsets[block + 1] += offsets[block];
+    }
+    std::vector<Edge<E>> edges(offsets[numBlocks]);
+    myGraphUtils::parallelFor(0, numBlocks, [&](size_t const block) {
+        std::mt19937_64 gen = makeGenerator(EDGES, block);
+        size_t k = offsets[block];
+        for (size_t i = block * BUILDER_BLOCK; i < std::min<size_t>(n, (block + 1) * BUILDER_BLOCK); i++) {
+            if(i % width + 1 < width && i + 1 < n) {
+                edges[k++] = makeEdge(i, i + 1, gen);
+            }
+            if(i + width < n) {
+                edges[k++] = makeEdge(i, i + width, gen);
+            }
         }
+    }, this->numThreads);
+    return edges;
+}
+
+/* Joins the nodes closer than r, with r such that about numEdges pairs are expected to be that close (ignoring the
+   borders). Nodes are bucketed in square cells of side r, so each one only looks at the 3 x 3 cells around it */
+template <typename N, typename E>
+std::vector<Edge<E>> GraphBuilder<N,E>::buildGeometricEdges(std::vector<Node<N,E>> const& nodes) const {
+    size_t const n = nodes.size();
+    if(n < 2) {
+        return {};
+    }
+    double const side = 201;
+    double const pairs = (double)n * (n - 1) / 2;
+    double const r = side * std::sqrt(std::min(1.0, this->numEdges / (pairs * std::acos(-1.0))));
+    size_t const cellsPerSide = std::max<size_t>(1, std::min<size_t>(side / r, std::sqrt((double)n)));
+    double const cellSide = side / cellsPerSide;
+    auto cellOf = [&](size_t const i) {
+        Coords const& c = nodes[i].getCoords();
+        size_t const x = std::min<size_t>(cellsPerSide - 1, (c[0] + 100) / cellSide);
+        size_t const y = std::min<size_t>(cellsPerSide - 1, (c[1] + 100) / cellSide);
+        return y * cellsPerSide + x;
+    };
+    //Counting sort of the nodes by cell
+    std::vector<size_t> cellStart(cellsPerSide * cellsPerSide + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        cellStart[cellOf(i) + 1]++;
     }
-    //Filling remaining edges (or creating a fully random graph)
-    for (int i = graph.getNumEdges(); i < this->numEdges; i++)
-    {
-        std::uniform_int_distribution<int> nodeId(0, this->numNodes - 1);
-        int idFrom = nodeId(gen), idTo = nodeId(gen);
-        graph.addEdge(idFrom, idTo, getRandomCost<E>(this->minEdgeWeight, this->maxEdgeWeight), true);
+    for (size_t c = 0; c + 1 < cellStart.size(); c++) {
+        cellStart[c + 1] += cellStart[c];
     }
-    
-    writeToFile(graph);
+    std::vector<int> byCell(n);
+    std::vector<size_t> next(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < n; i++) {
+        byCell[next[cellOf(i)]++] = i;
+    }
+    size_t const numBlocks = (n + BUILDER_BLOCK - 1) / BUILDER_BLOCK;
+    std::vector<std::vector<Edge<E>>> blockEdges(numBlocks);
+    myGraphUtils::parallelFor(0, numBlocks, [&](size_t const block) {
+        std::mt19937_64 gen = makeGenerator(EDGES, block);
+        for (size_t i = block * BUILDER_BLOCK; i < std::min(n, (block + 1) * BUILDER_BLOCK); i++) {
+            Coords const& a = nodes[i].getCoords();
+            size_t const cell = cellOf(i), cx = cell % cellsPerSide, cy = cell / cellsPerSide;
+            for (size_t y = cy > 0 ? cy - 1 : 0; y <= std::min(cy + 1, cellsPerSide - 1); y++) {
+                for (size_t x = cx > 0 ? cx - 1 : 0; x <= std::min(cx + 1, cellsPerSide - 1); x++) {
+                    size_t const c = y * cellsPerSide + x;
+                    for (size_t k = cellStart[c]; k < cellStart[c + 1]; k++) {
+                        size_t const j = byCell[k];
+                        Coords const& b = nodes[j].getCoords();
+                        double const dx = a[0] - b[0], dy = a[1] - b[1];
+                        if(j > i && dx * dx + dy * dy <= r * r) {
+                            blockEdges[block].push_back(makeEdge(i, j, gen));
+                        }
+                    }
+                }
+            }
+        }
+    }, this->numThreads);
+    std::vector<Edge<E>> edges;
+    for (std::vector<Edge<E>>& block : blockEdges) {
+        edges.insert(edges.end(), block.begin(), block.end());
+        std::vector<Edge<E>>().swap(block);
+    }
+    return edges;
+}
 
+/* Generates a graph following the model. The same settings and seed always give the same graph, whatever the number
+   of threads. If an output file was set, the graph is also written there
+   Connected graphs are strongly connected: every node can reach every other one, one-way edges included
+    Returns: an optional containing the graph, empty if a connected graph can not have that few edges (numNodes - 1,
+             or numNodes with one-way edges; ERDOS_RENYI and RMAT only, GRID is always connected from its first node and
+             GEOMETRIC ignores the setting) or the file can not be written */
+template <typename N, typename E>
+std::optional<Graph<N,E>> GraphBuilder<N,E>::build() {
+    bool const randomEdges = this->model == ERDOS_RENYI || this->model == RMAT;
+    if(randomEdges && this->connected && this->numEdges < minConnectedEdges()) {
+        return {};
+    }
+    if(randomEdges && this->numNodes == 0 && this->numEdges > 0) {
+        return {};
+    }
+    std::vector<Node<N,E>> nodes = buildNodes();
+    std::vector<Edge<E>> edges;
+    switch (this->model) {
+        case GRID:
+            edges = buildGridEdges();
+            break;
+        case GEOMETRIC:
+            edges = buildGeometricEdges(nodes);
+            break;
+        default:
+            edges = buildRandomEdges();
+    }
+    if(!this->outputFile.empty() && !writeToFile(nodes, edges)) {
+        return {};
+    }
+    Graph<N,E> graph;
+    graph.addNodes(std::move(nodes));
+    graph.addEdges(edges);
     return {graph};
 }
 
@@ -178,4 +411,37 @@ GraphBuilder<N,E> & GraphBuilder<N,E>::setEdgeWeightLimits(const E min, const E
     return *this;
 }
 
-#endif
\ No newline at end of file
+template <typename N, typename E>
+GraphBuilder<N,E> & GraphBuilder<N,E>::setModel(const GraphModel value) {
+    this->model = value;
+    return *this;
+}
+
+//Quadrant probabilities of RMAT: top left, top right, bottom left (the bottom right one gets the rest)
+template <typename N, typename E>
+GraphBuilder<N,E> & GraphBuilder<N,E>::setRmatProbabilities(const double a, const double b, const double c) {
+    this->rmatA = a; this->rmatB = b; this->rmatC = c;
+    return *this;
+}
+
+template <typename N, typename E>
+GraphBuilder<N,E> & GraphBuilder<N,E>::setSeed(const uint64_t value) {
+    this->seed = value;
+    return *this;
+}
+
+//Threads used to generate the graph, 0 means one per hardware thread
+template <typename N, typename E>
+GraphBuilder<N,E> & GraphBuilder<N,E>::setNumThreads(const unsigned int value) {
+    this->numThreads = value;
+    return *this;
+}
+
+//File the built graphs are also written to, in the text format; empty (the default) means none
+template <typename N, typename E>
+GraphBuilder<N,E> & GraphBuilder<N,E>::setOutputFile(std::string const& filename) {
+    this->outputFile = filename;
+    return *this;
+}
+
+#endif
@@ -0,0 +1,504 @@
+#ifndef GRAPH_UTILS_CH
+#define GRAPH_UTILS_CH
+
+#include "graph_struct.hh"
+#include "graph_utils_algorithms.hh"
+#include "graph_utils_heap.hh"
+#include <vector>
+#include <algorithm>
+#include <optional>
+#include <limits>
+#include <fstream>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+template <typename E>
+class CHWorkspace;
+
+/* Contraction hierarchy of a graph: every node gets a rank (the order it was contracted in), and the graph is
+   augmented with shortcuts so that every shortest path goes up in rank and then down. A query is then a bidirectional
+   Dijkstra that only follows arcs leading to higher ranks: the forward search on the outgoing ones, the backward
+   search on the incoming ones. Nodes are addressed by the dense indices of the graph the hierarchy was built on */
+template <typename E>
+class ContractionHierarchy {
+    private:
+        //Either an arc of the graph (first is its index in the CsrGraph, second is NONE) or a shortcut bypassing
+        //a contracted node (first and second are the two hierarchy arcs it replaces)
+        struct Arc {
+            int from, to;
+            E cost;
+            unsigned int first, second;
+        };
+        static constexpr unsigned int NONE = std::numeric_limits<unsigned int>::max();
+        static constexpr uint32_t MAGIC = 0x48434c47; //"GLCH"
+        static constexpr uint32_t VERSION = 1;
+        std::vector<int> ranks;
+        std::vector<Arc> arcs;
+        std::vector<unsigned int> upOffsets, upArcs;        //node -> arcs to higher ranks
+        std::vector<unsigned int> downOffsets, downArcs;    //node -> arcs from higher ranks
+        void unpack(unsigned int const arc, std::vector<unsigned int>& path) const;
+        bool isValid() const;
+    public:
+        ContractionHierarchy() = default;
+        template <typename N>
+        ContractionHierarchy(CsrGraph<N,E> const& graph, int const witnessLimit);
+        int getNumNodes() const;
+        int getNumShortcuts() const;
+        int getRank(int const index) const;
+        std::optional<E> query(int const from, int const to, CHWorkspace<E>& workspace, std::vector<unsigned int>* const path = nullptr) const;
+        bool save(std::string const& filename) const;
+        bool load(std::string const& filename);
+};
+
+/* The state of the hierarchy queries, kept between them so that back-to-back queries allocate nothing */
+template <typename E>
+class CHWorkspace {
+    private:
+        std::vector<E> distances[2];            //forward, backward
+        std::vector<unsigned int> parents[2];   //the hierarchy arc each node was reached with
+        DaryHeap<E> queues[2];
+        std::vector<int> touched;
+        void reset(int const numNodes);
+    public:
+        CHWorkspace() = default;
+    friend class ContractionHierarchy<E>;
+};
+
+/* Contracts the nodes one by one, in order of priority: the number of shortcuts contracting the node would add minus
+   the arcs it would remove, plus how many of its neighbours are already contracted (to spread the contraction evenly).
+   Priorities are updated lazily, when a node reaches the top of the queue. Contracting a node adds a shortcut between
+   each pair of its neighbours unless a witness search finds a path at least as short avoiding it; witness searches
+   give up after settling witnessLimit nodes, which only costs a superfluous shortcut */
+template <typename E>
+template <typename N>
+ContractionHierarchy<E>::ContractionHierarchy(CsrGraph<N,E> const& graph, int const witnessLimit) {
+    GRAPH_STATS_SCOPE("ContractionHierarchy");
+    GRAPH_STATS_PHASE("copy");
+    int const n = graph.getNumNodes();
+    E const max = std::numeric_limits<E>::max();
+    //Remaining graph: for every node not contracted yet, its arcs to and from the others not contracted yet
+    std::vector<std::vector<unsigned int>> out(n), in(n);
+    for (int i = 0; i < n; i++) {
+        for (unsigned int arc = graph.arcsBegin(i); arc < graph.arcsEnd(i); arc++) {
+            int const target = graph.getTarget(arc);
+            if(target == i) {
+                continue;
+            }
+            //Only the cheapest of the parallel arcs is kept
+            auto existing = std::find_if(out[i].begin(), out[i].end(), [&](unsigned int const a) { return arcs[a].to == target; });
+            if(existing == out[i].end()) {
+                out[i].push_back(arcs.size());
+                in[target].push_back(arcs.size());
+                arcs.push_back({i, target, graph.getCost(arc), arc, NONE});
+            } else if(graph.getCost(arc) < arcs[*existing].cost) {
+                arcs[*existing].cost = graph.getCost(arc);
+                arcs[*existing].first = arc;
+            }
+        }
+    }
+    ranks.assign(n, -1);
+    std::pmr::memory_resource* const scratch = myGraphUtils::getScratchResource();
+    ScratchVector<int> contractedNeighbours(n, 0, scratch);
+    ScratchVector<E> distances(n, max, scratch);
+    ScratchVector<int> touched(scratch);
+    DaryHeap<E> witnessQueue(n);
+    //Settles the remaining graph from "from", avoiding "skip", up to "limit" and witnessLimit nodes
+    auto witnessSearch = [&](int const from, int const skip, E const limit) {
+        for (int const node : touched) {
+            distances[node] = max;
+        }
+        touched.clear();
+        witnessQueue.clear();
+        distances[from] = 0;
+        touched.push_back(from);
+        witnessQueue.push(from, 0);
+        for (int settled = 0; !witnessQueue.empty() && settled < witnessLimit; settled++) {
+            auto const [distance, current] = witnessQueue.pop();
+            if(distance > limit) {
+                break;
+            }
+            GRAPH_STATS_ADD(SETTLED, 1);
+            GRAPH_STATS_ADD(RELAXATIONS, out[current].size());
+            for (unsigned int const a : out[current]) {
+                int const target = arcs[a].to;
+                E const cost = distance + arcs[a].cost;
+                if(target != skip && cost < distances[target]) {
+                    if(distances[target] == max) {
+                        touched.push_back(target);
+                    }
+                    distances[target] = cost;
+                    witnessQueue.pushOrDecrease(target, cost);
+                }
+            }
+        }
+    };
+    //Calls shortcut(inArc, outArc) for every pair of neighbours of the node that needs one
+    auto forEachShortcut = [&](int const node, auto const& shortcut) {
+        E maxOut = 0;
+        for (unsigned int const a : out[node]) {
+            maxOut = std::max(maxOut, arcs[a].cost);
+        }
+        for (unsigned int const inArc : in[node]) {
+            int const source = arcs[inArc].from;
+            witnessSearch(source, node, arcs[inArc].cost + maxOut);
+            for (unsigned int const outArc : out[node]) {
+                int const target = arcs[outArc].to;
+                if(target != source && arcs[inArc].cost + arcs[outArc].cost < distances[target]) {
+                    shortcut(inArc, outArc);
+                }
+            }
+        }
+    };
+    auto priority = [&](int const node) {
+        int shortcuts = 0;
+        forEachShortcut(node, [&shortcuts](unsigned int const, unsigned int const) { shortcuts++; });
+        return shortcuts - (int)(in[node].size() + out[node].size()) + contractedNeighbours[node];
+    };
+    GRAPH_STATS_PHASE("ordering");
+    DaryHeap<int> order(n);
+    for (int i = 0; i < n; i++) {
+        order.push(i, priority(i));
+    }
+    std::vector<std::vector<unsigned int>> up(n), down(n);
+    GRAPH_STATS_PHASE("contraction");
+    for (int rank = 0; !order.empty();) {
+        int const node = order.top().second;
+        int const updated = priority(node);
+        order.pop();
+        if(!order.empty() && updated > order.top().first) {
+            GRAPH_STATS_ADD(STALE_POPS, 1);
+            order.push(node, updated);
+            continue;
+        }
+        std::vector<std::pair<unsigned int, unsigned int>> shortcuts;
+        forEachShortcut(node, [&shortcuts](unsigned int const inArc, unsigned int const outArc) { shortcuts.push_back({inArc, outArc}); });
+        for (auto const& [inArc, outArc] : shortcuts) {
+            int const source = arcs[inArc].from, target = arcs[outArc].to;
+            E const cost = arcs[inArc].cost + arcs[outArc].cost;
+            auto existing = std::find_if(out[source].begin(), out[source].end(), [&](unsigned int const a) { return arcs[a].to == target; });
+            if(existing == out[source].end()) {
+                out[source].push_back(arcs.size());
+                in[target].push_back(arcs.size());
+                arcs.push_back({source, target, cost, inArc, outArc});
+            } else if(cost < arcs[*existing].cost) {
+                //The old arc is left out of the hierarchy: it is replaced in both lists
+                unsigned int const old = *existing;
+                *existing = arcs.size();
+                *std::find(in[target].begin(), in[target].end(), old) = arcs.size();
+                arcs.push_back({source, target, cost, inArc, outArc});
+            }
+        }
+        //The arcs left to the neighbours lead to nodes contracted later, so they go up in rank
+        ranks[node] = rank++;
+        up[node] = out[node];
+        down[node] = in[node];
+        for (unsigned int const a : out[node]) {
+            std::vector<unsigned int>& list = in[arcs[a].to];
+            list.erase(std::find(list.begin(), list.end(), a));
+            contractedNeighbours[arcs[a].to]++;
+        }
+        for (unsigned int const a : in[node]) {
+            std::vector<unsigned int>& list = out[arcs[a].from];
+            list.erase(std::find(list.begin(), list.end(), a));
+            contractedNeighbours[arcs[a].from]++;
+        }
+        out[node].clear();
+        in[node].clear();
+    }
+    GRAPH_STATS_PHASE("upward graph");
+    upOffsets.assign(n + 1, 0);
+    downOffsets.assign(n + 1, 0);
+    for (int i = 0; i < n; i++) {
+        upOffsets[i + 1] = upOffsets[i] + up[i].size();
+        downOffsets[i + 1] = downOffsets[i] + down[i].size();
+        upArcs.insert(upArcs.end(), up[i].begin(), up[i].end());
+        downArcs.insert(downArcs.end(), down[i].begin(), down[i].end());
+    }
+}
+
+template <typename E>
+int ContractionHierarchy<E>::getNumNodes() const {
+    return ranks.size();
+}
+
+template <typename E>
+int ContractionHierarchy<E>::getNumShortcuts() const {
+    int shortcuts = 0;
+    for (Arc const& arc : arcs) {
+        shortcuts += arc.second != NONE;
+    }
+    return shortcuts;
+}
+
+template <typename E>
+int ContractionHierarchy<E>::getRank(int const index) const {
+    return ranks[index];
+}
+
+//Appends to path the graph arcs a hierarchy arc stands for, in order
+template <typename E>
+void ContractionHierarchy<E>::unpack(unsigned int const arc, std::vector<unsigned int>& path) const {
+    std::vector<unsigned int> stack(1, arc);
+    while(!stack.empty()) {
+        Arc const& current = arcs[stack.back()];
+        stack.pop_back();
+        if(current.second == NONE) {
+            path.push_back(current.first);
+        } else {
+            stack.push_back(current.second);
+            stack.push_back(current.first);
+        }
+    }
+}
+
+template <typename E>
+void CHWorkspace<E>::reset(int const numNodes) {
+    if((int)distances[0].size() != numNodes) {
+        for (int side = 0; side < 2; side++) {
+            distances[side].assign(numNodes, std::numeric_limits<E>::max());
+            parents[side].assign(numNodes, 0);
+            queues[side].resize(numNodes);
+        }
+        touched.clear();
+        return;
+    }
+    for (int const node : touched) {
+        distances[0][node] = distances[1][node] = std::numeric_limits<E>::max();
+    }
+    touched.clear();
+    queues[0].clear();
+    queues[1].clear();
+}
+
+/* Computes the distance between two nodes (by index) with a bidirectional search on the upward arcs; each direction
+   stops once its queue holds nothing shorter than the best meeting found so far
+    Parameters:
+        -from, to:  the indices of the end nodes
+        -workspace: the state reused between queries
+        -path:      if not null, it is filled with the indices of the arcs of the graph on the path, in order
+    Returns: an optional containing the distance, empty if "to" can not be reached */
+template <typename E>
+std::optional<E> ContractionHierarchy<E>::query(int const from, int const to, CHWorkspace<E>& workspace, std::vector<unsigned int>* const path) const {
+    GRAPH_STATS_SCOPE("ContractionHierarchy::query");
+    E const max = std::numeric_limits<E>::max();
+    workspace.reset(getNumNodes());
+    std::vector<E>* const distances = workspace.distances;
+    DaryHeap<E>* const queues = workspace.queues;
+    distances[0][from] = 0;
+    distances[1][to] = 0;
+    workspace.touched.push_back(from);
+    workspace.touched.push_back(to);
+    queues[0].push(from, 0);
+    queues[1].push(to, 0);
+    E best = max;
+    int meeting = -1;
+    while(true) {
+        bool const forwardDone = queues[0].empty() || !(queues[0].top().first < best);
+        bool const backwardDone = queues[1].empty() || !(queues[1].top().first < best);
+        if(forwardDone && backwardDone) {
+            break;
+        }
+        int const side = forwardDone ? 1 : backwardDone ? 0 : (queues[1].top().first < queues[0].top().first);
+        auto const [distance, current] = queues[side].pop();
+        GRAPH_STATS_ADD(SETTLED, 1);
+        if(distances[1 - side][current] != max && distance + distances[1 - side][current] < best) {
+            best = distance + distances[1 - side][current];
+            meeting = current;
+        }
+        std::vector<unsigned int> const& offsets = side == 0 ? upOffsets : downOffsets;
+        std::vector<unsigned int> const& list = side == 0 ? upArcs : downArcs;
+        GRAPH_STATS_ADD(RELAXATIONS, offsets[current + 1] - offsets[current]);
+        for (unsigned int i = offsets[current]; i < offsets[current + 1]; i++) {
+            Arc const& arc = arcs[list[i]];
+            int const target = side == 0 ? arc.to : arc.from;
+            E const cost = distance + arc.cost;
+            if(cost < distances[side][target]) {
+                if(distances[0][target] == max && distances[1][target] == max) {
+                    workspace.touched.push_back(target);
+                }
+                distances[side][target] = cost;
+                workspace.parents[side][target] = list[i];
+                queues[side].pushOrDecrease(target, cost);
+            }
+        }
+    }
+    if(meeting == -1) {
+        return {};
+    }
+    if(path) {
+        path->clear();
+        std::vector<unsigned int> forward;
+        for (int node = meeting; node != from; node = arcs[workspace.parents[0][node]].from) {
+            forward.push_back(workspace.parents[0][node]);
+        }
+        for (auto arc = forward.rbegin(); arc != forward.rend(); arc++) {
+            unpack(*arc, *path);
+        }
+        for (int node = meeting; node != to; node = arcs[workspace.parents[1][node]].to) {
+            unpack(workspace.parents[1][node], *path);
+        }
+    }
+    return {best};
+}
+
+/* Saves the hierarchy in a binary file: a header (magic number, version, size and kind of the cost type) followed by the
+   ranks, the arcs and the upward and downward indices. The file is only meant to be read back on the same platform
+    Returns: whether the file could be written */
+template <typename E>
+bool ContractionHierarchy<E>::save(std::string const& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+    auto writeValue = [&file](auto const value) {
+        file.write(reinterpret_cast<char const*>(&value), sizeof(value));
+    };
+    auto writeVector = [&](auto const& values) {
+        writeValue((uint64_t)values.size());
+        file.write(reinterpret_cast<char const*>(values.data()), values.size() * sizeof(values[0]));
+    };
+    writeValue(MAGIC);
+    writeValue(VERSION);
+    writeValue(binaryTypeCode<E>());
+    writeVector(ranks);
+    writeVector(arcs);
+    writeVector(upOffsets);
+    writeVector(upArcs);
+    writeVector(downOffsets);
+    writeVector(downArcs);
+    return file.good();
+}
+
+/* Tells whether the arrays of a loaded hierarchy are consistent, so that queries stay in bounds: ranks and arc ends
+   are node indices, a shortcut only refers to arcs added before it (so unpacking ends), and the offsets of the
+   upward and downward indices go from 0 to the size of their arrays without going down, into arcs that exist.
+   The arcs of the graph a hierarchy refers to can only be checked against the graph, when it is queried */
+template <typename E>
+bool ContractionHierarchy<E>::isValid() const {
+    size_t const n = ranks.size();
+    for (int const rank : ranks) {
+        if(rank < 0 || (size_t)rank >= n) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < arcs.size(); i++) {
+        Arc const& arc = arcs[i];
+        if(arc.from < 0 || (size_t)arc.from >= n || arc.to < 0 || (size_t)arc.to >= n ||
+           (arc.second != NONE && (arc.first >= i || arc.second >= i))) {
+            return false;
+        }
+    }
+    auto isValidIndex = [&](std::vector<unsigned int> const& offsets, std::vector<unsigned int> const& indices) {
+        if(offsets.size() != n + 1 || offsets[0] != 0 || offsets[n] != indices.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if(offsets[i] > offsets[i + 1]) {
+                return false;
+            }
+        }
+        for (unsigned int const arc : indices) {
+            if(arc >= arcs.size()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return isValidIndex(upOffsets, upArcs) && isValidIndex(downOffsets, downArcs);
+}
+
+/* Loads a hierarchy written by save
+    Returns: whether the file could be read and holds a consistent hierarchy (see isValid) with the same cost type;
+             if not, the hierarchy is left unchanged */
+template <typename E>
+bool ContractionHierarchy<E>::load(std::string const& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open()) {
+        return false;
+    }
+    auto readValue = [&file](auto& value) {
+        return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(value));
+    };
+    file.seekg(0, std::ios::end);
+    std::streamoff const length = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if(length < 0) {
+        return false;
+    }
+    //The sizes are checked against what is left of the file before anything is allocated
+    auto readVector = [&](auto& values) {
+        uint64_t size;
+        if(!readValue(size) || size > (uint64_t)(length - file.tellg()) / sizeof(values[0])) {
+            return false;
+        }
+        values.resize(size);
+        return (bool)file.read(reinterpret_cast<char*>(values.data()), size * sizeof(values[0]));
+    };
+    uint32_t magic, version, costType;
+    if(!readValue(magic) || !readValue(version) || !readValue(costType) ||
+       magic != MAGIC || version != VERSION || costType != binaryTypeCode<E>()) {
+        return false;
+    }
+    ContractionHierarchy<E> loaded;
+    if(!readVector(loaded.ranks) || !readVector(loaded.arcs) || !readVector(loaded.upOffsets) || !readVector(loaded.upArcs) ||
+       !readVector(loaded.downOffsets) || !readVector(loaded.downArcs)) {
+        return false;
+    }
+    if(!loaded.isValid()) {
+        return false;
+    }
+    *this = std::move(loaded);
+    return true;
+}
+
+/* Builds the contraction hierarchy of a graph, see the ContractionHierarchy constructor
+    Parameters:
+        -graph:        a reference to the frozen graph, its costs must not be negative
+        -witnessLimit: how many nodes a witness search may settle before giving up
+    Returns: the hierarchy, which can be queried as long as the graph does not change */
+template <typename N, typename E>
+ContractionHierarchy<E> compute_CH(CsrGraph<N,E> const& graph, int const witnessLimit = 500) {
+    return ContractionHierarchy<E>(graph, witnessLimit);
+}
+
+template <typename N, typename E>
+ContractionHierarchy<E> compute_CH(Graph<N,E> const& graph, int const witnessLimit = 500) {
+    return compute_CH(graph.freeze(), witnessLimit);
+}
+
+/* Computes the shortest path between two nodes with a contraction hierarchy. The cost is the one compute_SP_Dijkstra
+   finds; among paths of the same cost, the two may pick different ones
+    Parameters:
+        -graph:     a reference to the frozen graph the hierarchy was built on
+        -hierarchy: the contraction hierarchy (see compute_CH)
+        -fromId:    the id of the starting node
+        -toId:      the id of the end node
+        -workspace: the state reused between queries
+    Returns: an optional containing the shortest path (see Path::toGraph), empty if the end node can not be reached */
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_CH(CsrGraph<N,E> const& graph, ContractionHierarchy<E> const& hierarchy, int const fromId, int const toId, CHWorkspace<E>& workspace) {
+    GRAPH_STATS_SCOPE("compute_SP_CH");
+    if(hierarchy.getNumNodes() != graph.getNumNodes()) {
+        throw std::invalid_argument("the contraction hierarchy was built on a different graph");
+    }
+    int const from = graph.getIndex(fromId), to = graph.getIndex(toId);
+    std::vector<unsigned int> arcs;
+    if(!hierarchy.query(from, to, workspace, &arcs)) {
+        return {};
+    }
+    for (unsigned int const arc : arcs) {
+        if(arc >= graph.getNumArcs()) {
+            throw std::invalid_argument("the contraction hierarchy was built on a different graph");
+        }
+    }
+    return graph.makePath(from, arcs);
+}
+
+template <typename N, typename E>
+std::optional<Path<E>> compute_SP_CH(CsrGraph<N,E> const& graph, ContractionHierarchy<E> const& hierarchy, int const fromId, int const toId) {
+    CHWorkspace<E> workspace;
+    return compute_SP_CH(graph, hierarchy, fromId, toId, workspace);
+}
+
+#endif
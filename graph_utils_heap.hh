@@ -0,0 +1,168 @@
+#ifndef GRAPH_UTILS_HEAP
+#define GRAPH_UTILS_HEAP
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include "graph_utils_stats.hh"
+
+/* Indexed d-ary min-heap over the items 0..capacity-1 (node indices), each with a key.
+   Knowing where every item sits in the heap allows decrease-key, so every item is in the heap at most once;
+   a higher arity makes the heap shallower, which helps when there are many more decrease-keys than pops */
+template <typename K, unsigned int D = 4>
+class DaryHeap {
+    private:
+        std::vector<std::pair<K,int>> heap; //(key, item)
+        std::vector<int> positions;         //item -> position in heap, -1 if absent
+        void siftUp(size_t position);
+        void siftDown(size_t position);
+    public:
+        DaryHeap(int const capacity = 0) : positions(capacity, -1) {};
+        void resize(int const capacity);
+        int getCapacity() const;
+        bool empty() const;
+        size_t size() const;
+        bool contains(int const item) const;
+        K getKey(int const item) const;
+        void push(int const item, K const key);
+        void decreaseKey(int const item, K const key);
+        bool pushOrDecrease(int const item, K const key);
+        std::pair<K,int> const& top() const;
+        std::pair<K,int> pop();
+        void clear();
+};
+
+template <typename K, unsigned int D>
+void DaryHeap<K,D>::siftUp(size_t position) {
+    std::pair<K,int> const moving = heap[position];
+    while(position > 0) {
+        size_t const parent = (position - 1) / D;
+        if(!(moving.first < heap[parent].first)) {
+            break;
+        }
+        heap[position] = heap[parent];
+        positions[heap[position].second] = position;
+        position = parent;
+    }
+    heap[position] = moving;
+    positions[moving.second] = position;
+}
+
+template <typename K, unsigned int D>
+void DaryHeap<K,D>::siftDown(size_t position) {
+    std::pair<K,int> const moving = heap[position];
+    size_t const size = heap.size();
+    while(true) {
+        size_t const first = position * D + 1;
+        if(first >= size) {
+            break;
+        }
+        size_t best = first;
+        size_t const last = first + D < size ? first + D : size;
+        for (size_t child = first + 1; child < last; child++) {
+            if(heap[child].first < heap[best].first) {
+                best = child;
+            }
+        }
+        if(!(heap[best].first < moving.first)) {
+            break;
+        }
+        heap[position] = heap[best];
+        positions[heap[position].second] = position;
+        position = best;
+    }
+    heap[position] = moving;
+    positions[moving.second] = position;
+}
+
+//Changes the range of the items, dropping the ones left: a search stopping at its targets leaves some behind
+template <typename K, unsigned int D>
+void DaryHeap<K,D>::resize(int const capacity) {
+    heap.clear();
+    positions.assign(capacity, -1);
+    heap.reserve(capacity);
+}
+
+template <typename K, unsigned int D>
+int DaryHeap<K,D>::getCapacity() const {
+    return positions.size();
+}
+
+template <typename K, unsigned int D>
+bool DaryHeap<K,D>::empty() const {
+    return heap.empty();
+}
+
+template <typename K, unsigned int D>
+size_t DaryHeap<K,D>::size() const {
+    return heap.size();
+}
+
+template <typename K, unsigned int D>
+bool DaryHeap<K,D>::contains(int const item) const {
+    return positions[item] != -1;
+}
+
+template <typename K, unsigned int D>
+K DaryHeap<K,D>::getKey(int const item) const {
+    return heap[positions[item]].first;
+}
+
+template <typename K, unsigned int D>
+void DaryHeap<K,D>::push(int const item, K const key) {
+    GRAPH_STATS_ADD(HEAP_PUSHES, 1);
+    heap.push_back({key, item});
+    siftUp(heap.size() - 1);
+}
+
+template <typename K, unsigned int D>
+void DaryHeap<K,D>::decreaseKey(int const item, K const key) {
+    GRAPH_STATS_ADD(HEAP_DECREASES, 1);
+    heap[positions[item]].first = key;
+    siftUp(positions[item]);
+}
+
+//Inserts the item, or lowers its key if it is already in the heap; returns false if nothing changed
+template <typename K, unsigned int D>
+bool DaryHeap<K,D>::pushOrDecrease(int const item, K const key) {
+    if(!contains(item)) {
+        push(item, key);
+        return true;
+    }
+    if(key < getKey(item)) {
+        decreaseKey(item, key);
+        return true;
+    }
+    return false;
+}
+
+template <typename K, unsigned int D>
+std::pair<K,int> const& DaryHeap<K,D>::top() const {
+    return heap.front();
+}
+
+template <typename K, unsigned int D>
+std::pair<K,int> DaryHeap<K,D>::pop() {
+    GRAPH_STATS_ADD(HEAP_POPS, 1);
+    std::pair<K,int> const result = heap.front();
+    positions[result.second] = -1;
+    if(heap.size() > 1) {
+        heap.front() = heap.back();
+        heap.pop_back();
+        siftDown(0);
+    } else {
+        heap.pop_back();
+    }
+    return result;
+}
+
+//Empties the heap in O(size), the capacity is kept
+template <typename K, unsigned int D>
+void DaryHeap<K,D>::clear() {
+    for (std::pair<K,int> const& entry : heap) {
+        positions[entry.second] = -1;
+    }
+    heap.clear();
+}
+
+#endif
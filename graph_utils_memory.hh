@@ -0,0 +1,73 @@
+#ifndef GRAPH_UTILS_MEMORY
+#define GRAPH_UTILS_MEMORY
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+/* Memory the algorithms take their temporaries from (work arrays, queues, edge lists), for the calling thread.
+   It is the default resource unless a ScratchArena is alive on the thread: the temporaries then come from a few large
+   blocks, which are all given back at once when the arena goes away, instead of one malloc and free each */
+
+//Size of the first block of a ScratchArena, each new block is larger than the previous one
+constexpr size_t SCRATCH_BLOCK_SIZE = 1 << 20;
+
+namespace myGraphUtils
+{
+    std::pmr::memory_resource* getScratchResource();
+    void setScratchResource(std::pmr::memory_resource* const resource);
+}
+
+/* A monotonic arena installed as the scratch resource of the calling thread for as long as it lives, then the previous
+   one is restored. It is not thread-safe: algorithms only take scratch memory on the thread that called them.
+   Whatever the algorithms return is allocated normally, so it outlives the arena */
+class ScratchArena {
+    private:
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::memory_resource* previous;
+    public:
+        ScratchArena(size_t const initialSize = SCRATCH_BLOCK_SIZE);
+        ~ScratchArena();
+        ScratchArena(ScratchArena const&) = delete;
+        ScratchArena& operator=(ScratchArena const&) = delete;
+        void release();
+        std::pmr::memory_resource* getResource();
+};
+
+//A vector of algorithm temporaries, allocated from the scratch resource of the thread that creates it
+template <typename T>
+using ScratchVector = std::pmr::vector<T>;
+
+inline std::pmr::memory_resource*& scratchResourceSlot() {
+    static thread_local std::pmr::memory_resource* resource = nullptr;
+    return resource;
+}
+
+inline std::pmr::memory_resource* myGraphUtils::getScratchResource() {
+    std::pmr::memory_resource* const resource = scratchResourceSlot();
+    return resource != nullptr ? resource : std::pmr::get_default_resource();
+}
+
+//Sets the scratch resource of the calling thread, nullptr goes back to the default resource
+inline void myGraphUtils::setScratchResource(std::pmr::memory_resource* const resource) {
+    scratchResourceSlot() = resource;
+}
+
+inline ScratchArena::ScratchArena(size_t const initialSize) : arena(initialSize), previous(scratchResourceSlot()) {
+    scratchResourceSlot() = &arena;
+}
+
+inline ScratchArena::~ScratchArena() {
+    scratchResourceSlot() = previous;
+}
+
+//Gives back all the memory taken so far: nothing allocated from the arena may be used afterwards
+inline void ScratchArena::release() {
+    arena.release();
+}
+
+inline std::pmr::memory_resource* ScratchArena::getResource() {
+    return &arena;
+}
+
+#endif
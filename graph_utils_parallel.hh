@@ -0,0 +1,215 @@
+#ifndef GRAPH_UTILS_PARALLEL
+#define GRAPH_UTILS_PARALLEL
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <exception>
+#include <mutex>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include "graph_utils_stats.hh"
+
+namespace myGraphUtils
+{
+    unsigned int defaultNumThreads();
+    template <typename F>
+    void parallelFor(size_t const begin, size_t const end, F const& body, unsigned int numThreads = 0);
+    template <typename S, typename F>
+    void parallelForWithState(size_t const begin, size_t const end, S const& makeState, F const& body, unsigned int numThreads = 0);
+    template <typename F>
+    void parallelForChunks(size_t const begin, size_t const end, F const& body, unsigned int numThreads = 0, size_t const grain = 4096);
+    template <typename T, typename A, typename C>
+    void parallelSort(std::vector<T,A>& items, C const& comp, unsigned int numThreads = 0);
+    template <typename T, typename A, typename K>
+    void parallelRadixSort(std::vector<T,A>& items, K const& key, unsigned int numThreads = 0);
+}
+
+//Below this many items per thread the sorts are not worth splitting
+constexpr size_t PARALLEL_SORT_GRAIN = 1 << 14;
+
+//Number of threads used when the caller passes 0
+inline unsigned int myGraphUtils::defaultNumThreads() {
+    unsigned int const n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+/* Calls body(i) for every i in [begin, end), spreading the indices over numThreads threads (the calling one included).
+   Indices are handed out one at a time, so each one should carry a reasonable amount of work (a tile, a source, a chunk).
+    Parameters:
+        -begin, end:  the index range
+        -body:        the function to call, it must be safe to call it concurrently on different indices
+        -numThreads:  the number of threads to use, 0 means one per hardware thread
+   The first exception thrown by body is rethrown once every thread has stopped */
+template <typename F>
+void myGraphUtils::parallelFor(size_t const begin, size_t const end, F const& body, unsigned int numThreads) {
+    if(numThreads == 0) {
+        numThreads = defaultNumThreads();
+    }
+    size_t const count = end > begin ? end - begin : 0;
+    if(numThreads > count) {
+        numThreads = count;
+    }
+    if(numThreads <= 1) {
+        for (size_t i = begin; i < end; i++) {
+            body(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next(begin);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    GRAPH_STATS_CAPTURE(run);
+    auto worker = [&]() {
+        GRAPH_STATS_ADOPT(run);
+        try {
+            for (size_t i = next++; i < end; i = next++) {
+                body(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!error) {
+                error = std::current_exception();
+            }
+            next = end;
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (unsigned int t = 1; t < numThreads; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/* Like parallelFor, but every thread first builds its own state with makeState() and then calls body(state, i) for the
+   indices it takes: for work reusing a buffer or a workspace from one index to the next, without sharing it */
+template <typename S, typename F>
+void myGraphUtils::parallelForWithState(size_t const begin, size_t const end, S const& makeState, F const& body, unsigned int numThreads) {
+    if(numThreads == 0) {
+        numThreads = defaultNumThreads();
+    }
+    size_t const count = end > begin ? end - begin : 0;
+    size_t const workers = std::min<size_t>(numThreads, count);
+    std::atomic<size_t> next(begin);
+    parallelFor(0, workers, [&](size_t const) {
+        auto state = makeState();
+        try {
+            for (size_t i = next++; i < end; i = next++) {
+                body(state, i);
+            }
+        } catch (...) {
+            next = end;
+            throw;
+        }
+    }, workers);
+}
+
+/* Calls body(chunkBegin, chunkEnd) over consecutive chunks of [begin, end) of about grain indices each,
+   for loops whose single iterations are too cheap to be handed out one by one */
+template <typename F>
+void myGraphUtils::parallelForChunks(size_t const begin, size_t const end, F const& body, unsigned int numThreads, size_t const grain) {
+    size_t const count = end > begin ? end - begin : 0;
+    size_t const chunks = (count + grain - 1) / grain;
+    parallelFor(0, chunks, [&](size_t const c) {
+        body(begin + c * grain, std::min(end, begin + (c + 1) * grain));
+    }, numThreads);
+}
+
+/* Sorts items according to comp: each thread sorts a chunk, then the chunks are merged pairwise, in parallel */
+template <typename T, typename A, typename C>
+void myGraphUtils::parallelSort(std::vector<T,A>& items, C const& comp, unsigned int numThreads) {
+    if(numThreads == 0) {
+        numThreads = defaultNumThreads();
+    }
+    size_t const chunks = std::min<size_t>(numThreads, items.size() / PARALLEL_SORT_GRAIN + 1);
+    if(chunks <= 1) {
+        std::sort(items.begin(), items.end(), comp);
+        return;
+    }
+    auto bound = [&](size_t const chunk) {
+        return items.begin() + items.size() * std::min(chunk, chunks) / chunks;
+    };
+    parallelFor(0, chunks, [&](size_t const c) {
+        std::sort(bound(c), bound(c + 1), comp);
+    }, numThreads);
+    for (size_t width = 1; width < chunks; width *= 2) {
+        parallelFor(0, (chunks + 2 * width - 1) / (2 * width), [&](size_t const pair) {
+            size_t const first = pair * 2 * width;
+            std::inplace_merge(bound(first), bound(first + width), bound(first + 2 * width), comp);
+        }, numThreads);
+    }
+}
+
+/* Stable LSD radix sort of items by an integral key, one byte per pass. Each thread builds the histogram of its
+   chunk and scatters it to its own slice of every bucket; passes where all the keys share the same byte are skipped,
+   so small cost ranges only take one or two passes
+    Parameters:
+        -items:      the items to sort
+        -key:        returns the integral key of an item, it is called twice per item for each pass
+        -numThreads: the number of threads to use, 0 means one per hardware thread
+   The buffer the items are scattered to comes from the allocator of the items */
+template <typename T, typename A, typename K>
+void myGraphUtils::parallelRadixSort(std::vector<T,A>& items, K const& key, unsigned int numThreads) {
+    using Key = std::decay_t<decltype(key(items.front()))>;
+    static_assert(std::is_integral_v<Key>, "parallelRadixSort needs an integral key");
+    using Bits = std::make_unsigned_t<Key>;
+    auto bits = [&key](T const& item) {
+        Bits b = static_cast<Bits>(key(item));
+        if constexpr (std::is_signed_v<Key>) {
+            //Flipping the sign bit makes the two's complement order match the unsigned one
+            b ^= Bits(1) << (sizeof(Bits) * 8 - 1);
+        }
+        return b;
+    };
+    if(numThreads == 0) {
+        numThreads = defaultNumThreads();
+    }
+    size_t const size = items.size();
+    size_t const chunks = std::min<size_t>(numThreads, size / PARALLEL_SORT_GRAIN + 1);
+    std::vector<T,A> buffer(size, items.get_allocator());
+    std::vector<T,A>* src = &items;
+    std::vector<T,A>* dst = &buffer;
+    std::vector<std::array<size_t, 256>> counts(chunks);
+    for (size_t shift = 0; shift < sizeof(Bits) * 8; shift += 8) {
+        parallelFor(0, chunks, [&](size_t const c) {
+            counts[c].fill(0);
+            for (size_t i = size * c / chunks; i < size * (c + 1) / chunks; i++) {
+                counts[c][(bits((*src)[i]) >> shift) & 0xFF]++;
+            }
+        }, numThreads);
+        //Turning the counts into starting positions: digit-major, chunk-minor keeps the sort stable
+        size_t position = 0;
+        bool skip = false;
+        for (size_t digit = 0; digit < 256 && !skip; digit++) {
+            size_t const start = position;
+            for (size_t c = 0; c < chunks; c++) {
+                size_t const count = counts[c][digit];
+                counts[c][digit] = position;
+                position += count;
+            }
+            skip = position - start == size;
+        }
+        if(skip) {
+            continue;
+        }
+        parallelFor(0, chunks, [&](size_t const c) {
+            for (size_t i = size * c / chunks; i < size * (c + 1) / chunks; i++) {
+                (*dst)[counts[c][(bits((*src)[i]) >> shift) & 0xFF]++] = (*src)[i];
+            }
+        }, numThreads);
+        std::swap(src, dst);
+    }
+    if(src != &items) {
+        items.swap(buffer);
+    }
+}
+
+#endif
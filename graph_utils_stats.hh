@@ -0,0 +1,276 @@
+#ifndef GRAPH_UTILS_STATS
+#define GRAPH_UTILS_STATS
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "graph_utils_memory.hh"
+
+/* Run statistics of the algorithms. They are only collected when the library is compiled with GRAPH_STATS_ENABLED
+   defined: otherwise the GRAPH_STATS_* macros expand to nothing and the algorithms carry no trace of them.
+   Each call of an instrumented algorithm becomes one AlgorithmStats record, handed to the observer set with
+   myGraphUtils::setStatsObserver; an algorithm called by another one counts towards the caller's record.
+   BYTES is not estimated by the algorithms: it counts what they take from the scratch resource while the record is open */
+
+enum StatsCounter {HEAP_PUSHES, HEAP_POPS, HEAP_DECREASES, STALE_POPS, RELAXATIONS, SETTLED, BYTES, NUM_STATS_COUNTERS};
+
+struct AlgorithmStats {
+    char const* algorithm = "";
+    std::array<uint64_t, NUM_STATS_COUNTERS> counters{};        //indexed by StatsCounter; BYTES counts the scratch memory allocated
+    long long totalNs = 0;
+    std::vector<std::pair<char const*, long long>> phases;     //name, ns
+    uint64_t get(StatsCounter const counter) const { return counters[counter]; }
+};
+
+class StatsObserver {
+    public:
+        virtual ~StatsObserver() = default;
+        virtual void onRun(AlgorithmStats const& stats) = 0;
+};
+
+/* Writes every record as a JSON object on its own line */
+class StatsTracer : public StatsObserver {
+    private:
+        std::ostream& out;
+        std::mutex mutex;
+    public:
+        StatsTracer(std::ostream& out) : out(out) {}
+        void onRun(AlgorithmStats const& stats) override;
+};
+
+/* Keeps every record, for inspection after the runs */
+class StatsRecorder : public StatsObserver {
+    private:
+        std::vector<AlgorithmStats> runs;
+        std::mutex mutex;
+    public:
+        void onRun(AlgorithmStats const& stats) override;
+        std::vector<AlgorithmStats> const& getRuns() const;
+        void clear();
+};
+
+class StatsScope;
+
+/* Installed as the scratch resource of a thread while a record is open on it: it passes the allocations on to the
+   resource it replaced, and adds their sizes to the BYTES counter of the record */
+class CountingResource : public std::pmr::memory_resource {
+    private:
+        StatsScope* scope = nullptr;
+        std::pmr::memory_resource* previous = nullptr;      //the scratch resource slot before install, nullptr for the default
+        std::pmr::memory_resource* upstream = nullptr;
+        void* do_allocate(size_t const bytes, size_t const alignment) override;
+        void do_deallocate(void* const pointer, size_t const bytes, size_t const alignment) override;
+        bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+    public:
+        void install(StatsScope* const scope);
+        void uninstall();
+};
+
+/* The record of the algorithm running on this thread, filled while the scope is alive. The counters are atomic since
+   the threads of parallelFor write to the record of the thread that started them */
+class StatsScope {
+    private:
+        bool active = false;
+        AlgorithmStats stats;
+        std::array<std::atomic<uint64_t>, NUM_STATS_COUNTERS> counters{};
+        CountingResource scratch;
+        std::chrono::steady_clock::time_point start, phaseStart;
+        char const* phaseName = nullptr;
+        void closePhase(std::chrono::steady_clock::time_point const now);
+    public:
+        StatsScope(char const* const algorithm);
+        ~StatsScope();
+        StatsScope(StatsScope const&) = delete;
+        StatsScope& operator=(StatsScope const&) = delete;
+        void add(StatsCounter const counter, uint64_t const amount);
+        void phase(char const* const name);
+};
+
+/* Lets a worker thread write to the record of the thread that started it, until it goes away. The scratch memory the
+   worker takes is counted as well. On the thread owning the record it does nothing */
+class StatsAdoption {
+    private:
+        StatsScope* previous;
+        CountingResource scratch;
+        bool adopted = false;
+    public:
+        StatsAdoption(StatsScope* const scope);
+        ~StatsAdoption();
+        StatsAdoption(StatsAdoption const&) = delete;
+        StatsAdoption& operator=(StatsAdoption const&) = delete;
+};
+
+namespace myGraphUtils
+{
+    void setStatsObserver(StatsObserver* const observer);
+    StatsObserver* getStatsObserver();
+    StatsScope*& currentStatsScope();
+}
+
+#ifdef GRAPH_STATS_ENABLED
+//Opens the record of an algorithm, until the end of the enclosing block
+#define GRAPH_STATS_SCOPE(algorithm) StatsScope graphStatsScope(algorithm)
+//Starts a new phase of the current record, closing the previous one
+#define GRAPH_STATS_PHASE(name) graphStatsScope.phase(name)
+//Adds to a counter of the record of the algorithm running on this thread, if any
+#define GRAPH_STATS_ADD(counter, amount) do { \
+        if(StatsScope* const graphStatsRun = myGraphUtils::currentStatsScope()) { graphStatsRun->add(counter, amount); } \
+    } while(0)
+//Lets a worker thread write to the record of the thread that started it
+#define GRAPH_STATS_CAPTURE(name) StatsScope* const name = myGraphUtils::currentStatsScope()
+#define GRAPH_STATS_ADOPT(name) StatsAdoption graphStatsAdoption(name)
+#else
+#define GRAPH_STATS_SCOPE(algorithm)
+#define GRAPH_STATS_PHASE(name)
+#define GRAPH_STATS_ADD(counter, amount)
+#define GRAPH_STATS_CAPTURE(name)
+#define GRAPH_STATS_ADOPT(name)
+#endif
+
+inline std::atomic<StatsObserver*>& statsObserverSlot() {
+    static std::atomic<StatsObserver*> observer(nullptr);
+    return observer;
+}
+
+//Sets the observer receiving the records, nullptr to stop collecting them. It must outlive the runs it observes
+inline void myGraphUtils::setStatsObserver(StatsObserver* const observer) {
+    statsObserverSlot().store(observer);
+}
+
+inline StatsObserver* myGraphUtils::getStatsObserver() {
+    return statsObserverSlot().load();
+}
+
+inline StatsScope*& myGraphUtils::currentStatsScope() {
+    static thread_local StatsScope* scope = nullptr;
+    return scope;
+}
+
+//A scope opened while another one is alive on the same thread stays inactive: its counts go to the outer one
+inline StatsScope::StatsScope(char const* const algorithm) {
+    if(myGraphUtils::currentStatsScope() != nullptr || myGraphUtils::getStatsObserver() == nullptr) {
+        return;
+    }
+    active = true;
+    stats.algorithm = algorithm;
+    start = phaseStart = std::chrono::steady_clock::now();
+    myGraphUtils::currentStatsScope() = this;
+    scratch.install(this);
+}
+
+inline StatsScope::~StatsScope() {
+    if(!active) {
+        return;
+    }
+    auto const now = std::chrono::steady_clock::now();
+    scratch.uninstall();
+    closePhase(now);
+    stats.totalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+    for (int c = 0; c < NUM_STATS_COUNTERS; c++) {
+        stats.counters[c] = counters[c].load(std::memory_order_relaxed);
+    }
+    myGraphUtils::currentStatsScope() = nullptr;
+    if(StatsObserver* const observer = myGraphUtils::getStatsObserver()) {
+        observer->onRun(stats);
+    }
+}
+
+inline void StatsScope::closePhase(std::chrono::steady_clock::time_point const now) {
+    if(phaseName != nullptr) {
+        stats.phases.push_back({phaseName, std::chrono::duration_cast<std::chrono::nanoseconds>(now - phaseStart).count()});
+    }
+    phaseStart = now;
+}
+
+inline void StatsScope::add(StatsCounter const counter, uint64_t const amount) {
+    counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+inline void StatsScope::phase(char const* const name) {
+    if(!active) {
+        return;
+    }
+    closePhase(std::chrono::steady_clock::now());
+    phaseName = name;
+}
+
+inline void CountingResource::install(StatsScope* const scope) {
+    this->scope = scope;
+    previous = scratchResourceSlot();
+    upstream = myGraphUtils::getScratchResource();
+    myGraphUtils::setScratchResource(this);
+}
+
+inline void CountingResource::uninstall() {
+    if(scope != nullptr) {
+        myGraphUtils::setScratchResource(previous);
+        scope = nullptr;
+    }
+}
+
+inline void* CountingResource::do_allocate(size_t const bytes, size_t const alignment) {
+    void* const pointer = upstream->allocate(bytes, alignment);
+    scope->add(BYTES, bytes);
+    return pointer;
+}
+
+inline void CountingResource::do_deallocate(void* const pointer, size_t const bytes, size_t const alignment) {
+    upstream->deallocate(pointer, bytes, alignment);
+}
+
+inline bool CountingResource::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+    return this == &other;
+}
+
+inline StatsAdoption::StatsAdoption(StatsScope* const scope) : previous(myGraphUtils::currentStatsScope()) {
+    if(scope == nullptr || scope == previous) {
+        return;
+    }
+    adopted = true;
+    myGraphUtils::currentStatsScope() = scope;
+    scratch.install(scope);
+}
+
+inline StatsAdoption::~StatsAdoption() {
+    if(adopted) {
+        scratch.uninstall();
+        myGraphUtils::currentStatsScope() = previous;
+    }
+}
+
+inline void StatsTracer::onRun(AlgorithmStats const& stats) {
+    static char const* const names[NUM_STATS_COUNTERS] = {"heap_pushes", "heap_pops", "heap_decreases", "stale_pops", "relaxations", "settled", "bytes"};
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "{\"algorithm\":\"" << stats.algorithm << "\",\"total_ns\":" << stats.totalNs;
+    for (int c = 0; c < NUM_STATS_COUNTERS; c++) {
+        out << ",\"" << names[c] << "\":" << stats.counters[c];
+    }
+    out << ",\"phases\":[";
+    for (size_t p = 0; p < stats.phases.size(); p++) {
+        out << (p > 0 ? "," : "") << "{\"name\":\"" << stats.phases[p].first << "\",\"ns\":" << stats.phases[p].second << "}";
+    }
+    out << "]}\n";
+}
+
+inline void StatsRecorder::onRun(AlgorithmStats const& stats) {
+    std::lock_guard<std::mutex> lock(mutex);
+    runs.push_back(stats);
+}
+
+inline std::vector<AlgorithmStats> const& StatsRecorder::getRuns() const {
+    return runs;
+}
+
+inline void StatsRecorder::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    runs.clear();
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "graph_utils_heap.hh"
+#include "graph_utils_algorithms.hh"
+#include "graph_utils_builder.hh"
+#include "graph_utils.hh"
+#include <cstdio>
+#include <fstream>
+#include <cassert>
+#include <iostream>
+
+//A heap resized while it still holds items must drop them, whichever way its capacity changes
+void testHeapResize() {
+    DaryHeap<int> heap(10);
+    for (int item = 0; item < 10; item++) {
+        heap.push(item, 10 - item);
+    }
+    heap.pop();
+    heap.resize(3);
+    assert(heap.empty() && heap.getCapacity() == 3);
+    for (int item = 0; item < 3; item++) {
+        assert(!heap.contains(item));
+        heap.push(item, 3 - item);
+    }
+    assert(heap.pop().second == 2);
+    heap.resize(20);
+    assert(heap.empty() && heap.getCapacity() == 20);
+    for (int item = 0; item < 20; item++) {
+        assert(!heap.contains(item));
+    }
+    heap.push(15, 1);
+    heap.push(4, 0);
+    assert(heap.pop().second == 4 && heap.pop().second == 15 && heap.empty());
+}
+
+//Connected random graphs are strongly connected: every node reaches every other one, whatever the direction of the edges
+void testBuilderConnected() {
+    for (DirectMode const direct : {ALLDIRECT, MIXED, ALLBIDIRECTIONAL}) {
+        for (GraphModel const model : {ERDOS_RENYI, RMAT}) {
+            for (unsigned int seed = 0; seed < 10; seed++) {
+                std::optional<Graph<int,int>> const graph = GraphBuilder<int,int>().setNumNodes(40).setNumEdges(50).setSeed(seed)
+                    .setModel(model).setDirect(direct).setConnected(true).build();
+                assert(graph);
+                CsrGraph<int,int> const csr = graph->freeze();
+                assert(myGraphUtils::isConnected(csr));
+                for (int from = 0; from < csr.getNumNodes(); from++) {
+                    ShortestPathTree<int> const tree = compute_SPT_Dijkstra(csr, csr.getId(from));
+                    for (int to = 0; to < csr.getNumNodes(); to++) {
+                        assert(tree.isReachable(to));
+                    }
+                }
+            }
+        }
+    }
+    //One-way edges can not connect n nodes with less than n of them
+    std::optional<Graph<int,int>> const sparse = GraphBuilder<int,int>().setNumNodes(40).setNumEdges(39).setDirect(ALLDIRECT)
+        .setConnected(true).build();
+    assert(!sparse);
+}
+
+//The header must match the body: a header announcing more records than the file holds is rejected before anything
+//is sized after it, as is a file with more records than its header
+void testParseHeaderCounts() {
+    char const* const filename = "tests.graph";
+    {
+        std::ofstream file(filename);
+        file << "2 4000000000 4000000000\n0 0 0 1\n1 1 1 1\n0 1 5 1\n";
+    }
+    Graph<int,int> graph;
+    std::vector<ParseError> errors = myGraphUtils::parseGraph(filename, graph);
+    assert(errors.size() == 1 && errors[0].line == 4 && errors[0].message.rfind("missing lines", 0) == 0);
+    {
+        std::ofstream file(filename);
+        file << "2 2 0\n0 0 0 1\n\n1 1 1 1\n0 1 5 1\n1 0 5 1\n";
+    }
+    errors = myGraphUtils::parseGraph(filename, graph);
+    assert(errors.size() == 1 && errors[0].line == 5 && errors[0].message.rfind("more lines", 0) == 0);
+    std::remove(filename);
+    assert(graph.getNumNodes() == 0);
+}
+
+int main() {
+    testHeapResize();
+    testBuilderConnected();
+    testParseHeaderCounts();
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}
@@ -24,12 +24,12 @@ int main(int argc, char** argv)
     std::cout << "ORIGINAL GRAPH" << std::endl;
     myGraphUtils::drawGraph(g);
     std::cout << "Graph creation time: " << stop - start << " seconds" << std::endl;
-    std::optional<Graph<int, int>> result = compute_SP_Floyd_Warshall(g);
+    std::optional<PathMatrix<int>> result = compute_SP_Floyd_Warshall(g);
     if(!result) {
         std::cout << "Graph not connected" << std::endl;
         return 0;
     }
     
     std::cout << "SP" << std::endl;
-    myGraphUtils::drawGraph(result.value());
+    myGraphUtils::drawGraph(result.value().toGraph(g));
 }